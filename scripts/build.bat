@@ -17,6 +17,9 @@ if not exist %objDir% (
     mkdir %objDir%\raytracer\utils
     mkdir %objDir%\math
 )
+if not exist %objDir%\raytracer\accel mkdir %objDir%\raytracer\accel
+if not exist %objDir%\raytracer\sampler mkdir %objDir%\raytracer\sampler
+if not exist %objDir%\raytracer\light mkdir %objDir%\raytracer\light
  
 :: Needed folders
 set extDir=%~dp0..\external
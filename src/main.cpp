@@ -12,22 +12,50 @@ using std::chrono::steady_clock;
 #include "viewport/vulkan_renderer.h"
 #include "viewport/window.h"
 #include "scene.h"
+#include "progress_reporter.h"
 
 #define RENDER_SILENT 1
+// Set to 1 to compare build and traversal of every BVH builder and layout on
+// MODEL_FILE instead of rendering.
+#define BENCHMARK_BVH 0
+// Set to 1 to compare the Moller-Trumbore and watertight triangle tests on
+// MODEL_FILE instead of rendering.
+#define BENCHMARK_TRIANGLE 0
+// Set to 1 to time ray queries and a single threaded render of the random
+// sphere scene. Build with and without RAYTRACER_VIRTUAL_DISPATCH defined to
+// compare virtual and tagged dispatch of geometry and materials.
+#define BENCHMARK_DISPATCH 0
 
 const char* RENDER_IMAGE = "../renders/teddy_render_01.png";
+const char* SAMPLE_COUNT_IMAGE = "../renders/teddy_render_01_samples.png";
 const char* MODEL_FILE = "../assets/teddy.obj";
 
-bool isRendering = false;
+// Worker threads of the render pool. 0 uses every hardware thread but two,
+// which are left to the viewport and the rest of the system.
+const int RENDER_THREAD_COUNT = 0;
+// Seconds between progress reports while rendering.
+const double PROGRESS_INTERVAL = 1.0;
 
-raytracer::Mesh getMeshFromFile(const char* path)
+// Created on first use and shared by every render, so repeated renders from
+// the viewport reuse the same workers. Shut down when the program exits.
+ThreadPool &getRenderThreadPool()
+{
+    static ThreadPool pool(RENDER_THREAD_COUNT > 0
+                               ? RENDER_THREAD_COUNT
+                               : std::max(1, ThreadPool::getHardwareThreadCount() - 2));
+    return pool;
+}
+
+// The mesh material is added to materialTable.
+raytracer::Mesh getMeshFromFile(const char* path, raytracer::MaterialTable &materialTable,
+                                const raytracer::BVHSettings &bvhSettings = raytracer::BVHSettings())
 {
     using namespace tinyobj;
     using namespace raytracer;
 
     std::cout << "Loading 3D Model: " << path << std::endl;
     
-    shared_ptr<Material> mat = make_shared<Dielectric>(Color::one, 1.52);
+    uint32_t mat = materialTable.add(make_shared<Dielectric>(Color::one, 1.52));
 
     ObjReaderConfig readerConfig;
     readerConfig.mtl_search_path = "./";
@@ -52,7 +80,84 @@ raytracer::Mesh getMeshFromFile(const char* path)
     const std::vector<material_t> &materials = reader.GetMaterials();
 
 
-    std::vector<Triangle> triangles;
+    // OBJ faces index positions, normals and texture coordinates separately.
+    // Every distinct combination becomes one shared vertex.
+    struct VertexKey
+    {
+        int position, normal, texCoord;
+        bool operator==(const VertexKey &other) const
+        {
+            return position == other.position && normal == other.normal && texCoord == other.texCoord;
+        }
+    };
+    struct VertexKeyHash
+    {
+        size_t operator()(const VertexKey &key) const
+        {
+            uint64_t h = static_cast<uint32_t>(key.position);
+            h = h * 0x9E3779B97F4A7C15ull + static_cast<uint32_t>(key.normal);
+            h = h * 0x9E3779B97F4A7C15ull + static_cast<uint32_t>(key.texCoord);
+            return static_cast<size_t>(h ^ (h >> 32));
+        }
+    };
+
+    TriangleMesh triangleMesh;
+    std::unordered_map<VertexKey, uint32_t, VertexKeyHash> vertexMap;
+    bool hasNormals = !attribs.normals.empty();
+    bool hasTexCoords = !attribs.texcoords.empty();
+    bool hasColors = attribs.colors.size() == attribs.vertices.size();
+
+    auto getVertex = [&](const index_t &idx)
+    {
+        VertexKey key{idx.vertex_index, idx.normal_index, idx.texcoord_index};
+        auto found = vertexMap.find(key);
+        if (found != vertexMap.end())
+            return found->second;
+
+        uint32_t vertex = triangleMesh.getVertexCount();
+        vertexMap.emplace(key, vertex);
+
+        size_t v = size_t(idx.vertex_index);
+        triangleMesh.positions.push_back(Point(static_cast<double>(attribs.vertices[3 * v + 0]),
+                                               static_cast<double>(attribs.vertices[3 * v + 1]),
+                                               static_cast<double>(attribs.vertices[3 * v + 2])));
+
+        if (hasNormals)
+        {
+            Vector3 normal(0.0, 0.0, 0.0);
+            if (idx.normal_index >= 0)
+            {
+                size_t n = size_t(idx.normal_index);
+                normal = Vector3(static_cast<double>(attribs.normals[3 * n + 0]),
+                                 static_cast<double>(attribs.normals[3 * n + 1]),
+                                 static_cast<double>(attribs.normals[3 * n + 2]));
+            }
+            triangleMesh.normals.push_back(normal);
+        }
+
+        if (hasTexCoords)
+        {
+            Vector3 texCoords(0.0, 0.0, 0.0);
+            if (idx.texcoord_index >= 0)
+            {
+                size_t t = size_t(idx.texcoord_index);
+                texCoords = Vector3(static_cast<double>(attribs.texcoords[2 * t + 0]),
+                                    static_cast<double>(attribs.texcoords[2 * t + 1]),
+                                    0.0);
+            }
+            triangleMesh.texCoords.push_back(texCoords);
+        }
+
+        if (hasColors)
+        {
+            triangleMesh.colors.push_back(Color(static_cast<double>(attribs.colors[3 * v + 0]),
+                                                static_cast<double>(attribs.colors[3 * v + 1]),
+                                                static_cast<double>(attribs.colors[3 * v + 2])));
+        }
+
+        return vertex;
+    };
+
     std::cout << "Shape Count: " << shapes.size() << std::endl;
     for (size_t s = 0; s < shapes.size(); s++)
     {
@@ -63,79 +168,320 @@ raytracer::Mesh getMeshFromFile(const char* path)
         {
             size_t fv = size_t(shapes[s].mesh.num_face_vertices[f]);
 
-            vector<Point> vertices;
-            vector<Vector3> normals;
-            vector<Vector3> texCoords;
-            vector<Color> colors;
-
-            vertices.resize(fv, Point::zero);
-            normals.resize(fv, Vector3::zero);
-            texCoords.resize(fv, Vector3::zero);
-            colors.resize(fv, Color::one);
+            // per-face material
+            int matId = shapes[s].mesh.material_ids[f];
 
-            for (size_t v = 0; v < fv; v++)
+            // Faces with more than three vertices are split into a fan.
+            uint32_t first = getVertex(shapes[s].mesh.indices[indexOffset]);
+            for (size_t v = 1; v + 1 < fv; v++)
             {
-                tinyobj::index_t idx = shapes[s].mesh.indices[indexOffset + v];
+                triangleMesh.addTriangle(first,
+                                         getVertex(shapes[s].mesh.indices[indexOffset + v]),
+                                         getVertex(shapes[s].mesh.indices[indexOffset + v + 1]),
+                                         matId);
+            }
+
+            indexOffset += fv;
+        }
+    }
 
-                Point currVertex(0.0, 0.0, 0.0);
-                currVertex.x = static_cast<double>(attribs.vertices[3 * size_t(idx.vertex_index) + 0]);
-                currVertex.y = static_cast<double>(attribs.vertices[3 * size_t(idx.vertex_index) + 1]);
-                currVertex.z = static_cast<double>(attribs.vertices[3 * size_t(idx.vertex_index) + 2]);
+    std::cout << "Vertex Count: " << triangleMesh.getVertexCount()
+              << ", Triangle Count: " << triangleMesh.getTriangleCount()
+              << ", Memory: " << triangleMesh.getMemoryUsage() / (1024.0 * 1024.0) << " MB" << std::endl;
 
-                Vector3 currNormal(0.0, 0.0, 0.0);
-                if (idx.normal_index >= 0)
-                {
-                    currNormal.x = static_cast<double>(attribs.normals[3 * size_t(idx.normal_index) + 0]);
-                    currNormal.y = static_cast<double>(attribs.normals[3 * size_t(idx.normal_index) + 1]);
-                    currNormal.z = static_cast<double>(attribs.normals[3 * size_t(idx.normal_index) + 2]);
-                }
+    Mesh mesh(mat, std::move(triangleMesh), bvhSettings);
+    std::cout << mesh.getBVHStats() << std::endl;
 
-                Vector3 currTexCoords(0.0, 0.0, 0.0);
-                if (idx.texcoord_index >= 0)
-                {
-                    currTexCoords.x = static_cast<double>(attribs.texcoords[2 * size_t(idx.texcoord_index) + 0]);
-                    currTexCoords.y = static_cast<double>(attribs.texcoords[2 * size_t(idx.texcoord_index) + 1]);
-                }
+    return mesh;
+}
 
-                Color currColor(1.0, 1.0, 1.0);
-                currColor.x = static_cast<double>(attribs.colors[3 * size_t(idx.vertex_index) + 0]);
-                currColor.y = static_cast<double>(attribs.colors[3 * size_t(idx.vertex_index) + 1]);
-                currColor.z = static_cast<double>(attribs.colors[3 * size_t(idx.vertex_index) + 2]);
+/**
+ * Traces one primary ray per pixel against the mesh alone and reports the
+ * traversal cost of closest hit and any hit (occlusion) queries, to compare
+ * acceleration structure quality across assets.
+ */
+void reportMeshTraversal(const raytracer::Mesh &mesh, const raytracer::Camera &camera, const raytracer::Image &image)
+{
+    using namespace raytracer;
 
-                vertices[v] = currVertex;
-                normals[v] = currNormal;
-                texCoords[v] = currTexCoords;
-                colors[v] = currColor;
+    for (bool isOcclusion : {false, true})
+    {
+        TraversalStats stats;
+        HitInfo hit;
+        int hitCount = 0;
+
+        auto start = steady_clock::now();
+        for (int y = 0; y < image.height; y++)
+        {
+            for (int x = 0; x < image.width; x++)
+            {
+                double u = (x + 0.5) / (image.width - 1);
+                double v = (image.height - 1 - (y + 0.5)) / (image.height - 1);
+                Ray ray = camera.getRay(u, v);
+                bool isHit = isOcclusion ? mesh.isOccluded(ray, 0.0001, INFINITY, stats)
+                                         : mesh.isHit(ray, 0.0001, INFINITY, hit, stats);
+                if (isHit)
+                    hitCount++;
             }
+        }
+        duration<double> elapsed = steady_clock::now() - start;
 
-            indexOffset += fv;
+        std::cout << (isOcclusion ? "Any hit " : "Closest hit ") << stats << ", " << hitCount << " hits, "
+                  << stats.rays / elapsed.count() / 1e6 << " Mrays/s" << std::endl;
+    }
+}
 
-            // per-face material
-            int matId = shapes[s].mesh.material_ids[f];
+void onPixelsProcessed(uint8_t* pixels)
+{
+    
+}
+
+int benchmarkBVH()
+{
+    using namespace raytracer;
+
+    Camera camera(45.0, 16.0 / 9.0, 13.0, 0.0, Point(0.0, 1.0, 6.0), Point(0.0, 0.0, 0.0));
+    Image image(640, 360);
+
+    for (BVHBuilder builder : {BVHBuilder::SAH, BVHBuilder::LBVH, BVHBuilder::SBVH})
+    {
+        for (BVHLayout layout : {BVHLayout::BINARY, BVHLayout::WIDE4, BVHLayout::WIDE8})
+        {
+            BVHSettings settings;
+            settings.builder = builder;
+            settings.layout = layout;
+            settings.numThreads = ThreadPool::getHardwareThreadCount();
+            MaterialTable materials;
+            Mesh mesh = getMeshFromFile(MODEL_FILE, materials, settings);
+            reportMeshTraversal(mesh, camera, image);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Times the double precision Moller-Trumbore test of Triangle against the
+ * packed single precision watertight test used by Mesh, on rays aimed at
+ * random points of random triangles. The watertight time includes its per
+ * ray setup, which traversal pays once per ray rather than per triangle.
+ * Also counts rays aimed at the midpoints of shared edges that slip between
+ * both triangles of the edge.
+ */
+int benchmarkTriangleIntersection()
+{
+    using namespace raytracer;
+
+    MaterialTable materials;
+    Mesh mesh = getMeshFromFile(MODEL_FILE, materials);
+    const TriangleMesh &triangleMesh = mesh.getTriangleMesh();
+    const uint32_t triangleCount = triangleMesh.getTriangleCount();
+    if (triangleCount == 0)
+        return 1;
+
+    std::vector<PackedTriangle> packed(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; i++)
+        packed[i] = PackedTriangle(triangleMesh.getVertex(i, 0), triangleMesh.getVertex(i, 1), triangleMesh.getVertex(i, 2));
+
+    // Origins and directions are stored rather than Rays, which hold
+    // references to their own members.
+    struct Query
+    {
+        uint32_t triangle;
+        Point origin;
+        Vector3 direction;
+    };
 
-            Triangle triangle(mat, vertices, normals, texCoords, colors, matId);
-            triangles.push_back(triangle);
+    auto makeQuery = [&](uint32_t triangle, const Point &target)
+    {
+        Point origin = target + Vector3::randomSpherical() * 2.0;
+        return Query{triangle, origin, target - origin};
+    };
+
+    const int queryCount = 1000000;
+    std::vector<Query> queries;
+    queries.reserve(queryCount);
+    for (int i = 0; i < queryCount; i++)
+    {
+        uint32_t triangle = std::min(triangleCount - 1, static_cast<uint32_t>(math::random() * triangleCount));
+        double u = math::random();
+        double v = math::random();
+        if (u + v > 1.0)
+        {
+            u = 1.0 - u;
+            v = 1.0 - v;
         }
+        const Point &v0 = triangleMesh.getVertex(triangle, 0);
+        Point target = v0 + (triangleMesh.getVertex(triangle, 1) - v0) * u + (triangleMesh.getVertex(triangle, 2) - v0) * v;
+        queries.push_back(makeQuery(triangle, target));
     }
 
-    Mesh mesh(mat, triangles);
+    auto isHitMollerTrumbore = [&](const Query &query, uint32_t triangle)
+    {
+        double t;
+        Ray ray(query.origin, query.direction);
+        return Triangle::intersect(ray, triangleMesh.getVertex(triangle, 0), triangleMesh.getVertex(triangle, 1),
+                                   triangleMesh.getVertex(triangle, 2), 0.0001, INFINITY, t);
+    };
 
-    return mesh;
+    auto isHitWatertight = [&](const Query &query, uint32_t triangle)
+    {
+        double t;
+        Ray ray(query.origin, query.direction);
+        return packed[triangle].intersect(WatertightRay(ray), 0.0001, INFINITY, t);
+    };
+
+    for (int method = 0; method < 2; method++)
+    {
+        int hitCount = 0;
+        auto start = steady_clock::now();
+        for (const Query &query : queries)
+        {
+            if (method == 0 ? isHitMollerTrumbore(query, query.triangle) : isHitWatertight(query, query.triangle))
+                hitCount++;
+        }
+        duration<double, std::nano> elapsed = steady_clock::now() - start;
+
+        std::cout << (method == 0 ? "Moller-Trumbore: " : "Watertight: ")
+                  << elapsed.count() / queryCount << "ns per test, "
+                  << hitCount << "/" << queryCount << " hits" << std::endl;
+    }
+
+    // Pairs of triangles sharing an edge.
+    std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> edges;
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            uint64_t a = triangleMesh.indices[3 * size_t(i) + c];
+            uint64_t b = triangleMesh.indices[3 * size_t(i) + (c + 1) % 3];
+            uint64_t key = std::min(a, b) << 32 | std::max(a, b);
+            auto found = edges.find(key);
+            if (found == edges.end())
+                edges.emplace(key, std::make_pair(i, UINT32_MAX));
+            else
+                found->second.second = i;
+        }
+    }
+
+    int edgeCount = 0;
+    int cracks[2] = {0, 0};
+    for (const auto &edge : edges)
+    {
+        uint32_t first = edge.second.first;
+        uint32_t second = edge.second.second;
+        if (second == UINT32_MAX)
+            continue;
+
+        // Rays come from around the shared normal, so that the two
+        // triangles cover both sides of the edge and any miss is a crack
+        // rather than a ray grazing past a silhouette.
+        // Edges next to degenerate triangles are skipped, since those have
+        // no surface to cover the edge with.
+        auto isDegenerate = [&](uint32_t triangle)
+        {
+            const Point &v0 = triangleMesh.getVertex(triangle, 0);
+            return Vector3::cross(triangleMesh.getVertex(triangle, 1) - v0, triangleMesh.getVertex(triangle, 2) - v0).lengthSquared() == 0.0;
+        };
+        Vector3 normal = triangleMesh.getTriangleNormal(first) + triangleMesh.getTriangleNormal(second);
+        if (isDegenerate(first) || isDegenerate(second) || normal.lengthSquared() < 0.5)
+            continue;
+
+        const Point &a = triangleMesh.positions[edge.first >> 32];
+        const Point &b = triangleMesh.positions[edge.first & 0xffffffff];
+        Point target = (a + b) * 0.5;
+        Point origin = target + normal.normalize() * 2.0 + Vector3::randomSpherical() * 0.2;
+        Query query{first, origin, target - origin};
+        edgeCount++;
+
+        if (!isHitMollerTrumbore(query, first) && !isHitMollerTrumbore(query, second))
+            cracks[0]++;
+        if (!isHitWatertight(query, first) && !isHitWatertight(query, second))
+            cracks[1]++;
+    }
+
+    std::cout << "Rays through shared edges missing both triangles: "
+              << cracks[0] << "/" << edgeCount << " Moller-Trumbore, "
+              << cracks[1] << "/" << edgeCount << " watertight" << std::endl;
+
+    return 0;
 }
 
-void onPixelsProcessed(uint8_t* pixels)
+int benchmarkDispatch()
 {
-    
+    using namespace raytracer;
+
+#ifdef RAYTRACER_VIRTUAL_DISPATCH
+    std::cout << "Virtual dispatch" << std::endl;
+#else
+    std::cout << "Tagged dispatch" << std::endl;
+#endif
+
+    Camera camera(25.0, 16.0 / 9.0, 13.0, 0.25, Point(8.0, 2.5, 7.0), Point(0.0, 0.0, -10.0));
+    Image image(640, 360);
+    image.samplesPerPixel = 4;
+    image.maxBounces = 6;
+
+    Scene scene(camera, image);
+    scene.setOnPixelsProcessedListener(onPixelsProcessed);
+    GeometryList world = scene.generateRandomScene();
+
+    // Ray queries only: no scattering, no random numbers.
+    const int passes = 10;
+    for (bool isOcclusion : {false, true})
+    {
+        HitInfo hit;
+        long long hitCount = 0;
+
+        auto start = steady_clock::now();
+        for (int pass = 0; pass < passes; pass++)
+        {
+            for (int y = 0; y < image.height; y++)
+            {
+                for (int x = 0; x < image.width; x++)
+                {
+                    double u = (x + 0.5) / (image.width - 1);
+                    double v = (image.height - 1 - (y + 0.5)) / (image.height - 1);
+                    Ray ray = camera.getRay(u, v);
+                    bool isHit = isOcclusion ? world.isOccluded(ray, 0.0001, INFINITY)
+                                             : world.isHit(ray, 0.0001, INFINITY, hit);
+                    if (isHit)
+                        hitCount++;
+                }
+            }
+        }
+        duration<double> elapsed = steady_clock::now() - start;
+
+        double rays = static_cast<double>(passes) * image.width * image.height;
+        std::cout << (isOcclusion ? "Any hit: " : "Closest hit: ") << hitCount << " hits, "
+                  << rays / elapsed.count() / 1e6 << " Mrays/s" << std::endl;
+    }
+
+    auto start = steady_clock::now();
+    ThreadPool singleThread(1);
+    scene.render(singleThread);
+    duration<double> elapsed = steady_clock::now() - start;
+    std::cout << "Render: " << elapsed.count() << "s" << std::endl;
+
+    return 0;
 }
 
-int renderImage()
+raytracer::Image getRenderImageSettings()
 {
-    isRendering = true;
+    raytracer::Image image(640, 360);
+    image.samplesPerPixel = 64;
+    image.maxBounces = 6;
+    image.isAdaptive = true;
+    image.minSamplesPerPixel = 8;
+    image.adaptiveThreshold = 0.02;
+    image.targetImageLocation = RENDER_IMAGE;
+    return image;
+}
 
+std::unique_ptr<Scene> createRenderScene(const raytracer::Image &image)
+{
     using namespace raytracer;
 
-    Mesh mesh = getMeshFromFile(MODEL_FILE);
-
     Camera camera(45.0,                    // FOV
                   16.0 / 9.0,              // Aspect Ratio
                   13.0,                    // Focus Distance
@@ -143,20 +489,55 @@ int renderImage()
                   Point(0.0, 1.0, 6.0),    // Camera position
                   Point(0.0, 0.0, 0.0)); // Look At position
 
-    Image image(640, 360);
-    image.samplesPerPixel = 16;
-    image.maxBounces = 6;
-    image.targetImageLocation = RENDER_IMAGE;
+    auto scene = std::make_unique<Scene>(camera, image);
+    Mesh mesh = getMeshFromFile(MODEL_FILE, scene->getMaterials());
+    scene->generateSceneFromModel(mesh);
+    scene->setOnPixelsProcessedListener(onPixelsProcessed);
 
-    Scene scene(camera, image);
-    scene.generateSceneFromModel(mesh);
-    scene.setOnPixelsProcessedListener(onPixelsProcessed);
+    return scene;
+}
+
+void writeRender(const Scene &scene, const raytracer::Image &image)
+{
+    stbi_write_png(image.targetImageLocation,
+                   image.width,
+                   image.height,
+                   image.colorChannels,
+                   &scene.pixels,
+                   image.width * image.colorChannels);
+
+    // Sample count AOV, white where a pixel took samplesPerPixel samples.
+    const std::vector<int> &sampleCounts = scene.getSampleCounts();
+    std::vector<uint8_t> sampleCountPixels(sampleCounts.size());
+    long long totalSamples = 0;
+    for (size_t i = 0; i < sampleCounts.size(); i++)
+    {
+        totalSamples += sampleCounts[i];
+        sampleCountPixels[i] = static_cast<uint8_t>(255 * sampleCounts[i] / image.samplesPerPixel);
+    }
+    std::cout << "Average samples per pixel: " << static_cast<double>(totalSamples) / sampleCounts.size() << std::endl;
+
+    stbi_write_png(SAMPLE_COUNT_IMAGE,
+                   image.width,
+                   image.height,
+                   1,
+                   sampleCountPixels.data(),
+                   image.width);
+}
+
+int renderImage()
+{
+    raytracer::Image image = getRenderImageSettings();
+    std::unique_ptr<Scene> scene = createRenderScene(image);
 
     auto start = steady_clock::now();
     
     std::cout << "Started rendering the scene:" << std::endl;
 
-    scene.render(ThreadUsage::MAX_MINUS_2);
+    RenderJob job = scene->renderAsync(getRenderThreadPool());
+    ProgressReporter reporter(job, PROGRESS_INTERVAL);
+    job.wait();
+    reporter.stop();
 
     auto end = steady_clock::now();
     duration<double> elapsed = end - start;
@@ -164,38 +545,86 @@ int renderImage()
     std::cerr << std::endl
               << "Time taken to render: " << elapsed.count() << "s" << std::endl;
 
-    stbi_write_png(image.targetImageLocation,
-                   image.width,
-                   image.height,
-                   image.colorChannels,
-                   &scene.pixels,
-                   image.width * image.colorChannels);
-
-    isRendering = false;
+    writeRender(*scene, image);
 
     return 0;
 }
 
+// Scene of the viewport, built once when the viewport opens and rendered
+// again on every click. The render runs on the render pool while the
+// viewport keeps drawing, and is written out by onViewportUpdate once done.
+std::unique_ptr<Scene> viewportScene;
+RenderJob viewportJob;
+std::unique_ptr<ProgressReporter> viewportReporter;
+steady_clock::time_point viewportRenderStart;
+
+// Runs on the UI thread, so it only starts the render.
 void onRenderClicked()
 {
+    // The callback repeats while ENTER is held.
+    if (!viewportJob.isDone())
+        return;
+
     std::cout << "Render called" << std::endl;
-    if (!isRendering)
-        renderImage();
+    viewportRenderStart = steady_clock::now();
+    viewportJob = viewportScene->renderAsync(getRenderThreadPool());
+    viewportReporter = std::make_unique<ProgressReporter>(viewportJob, PROGRESS_INTERVAL);
+}
+
+void onViewportUpdate()
+{
+    if (!viewportJob.isValid() || !viewportJob.isDone())
+        return;
+
+    viewportJob.wait();
+    viewportReporter.reset();
+    duration<double> elapsed = steady_clock::now() - viewportRenderStart;
+    std::cerr << "Time taken to render: " << elapsed.count() << "s" << std::endl;
+
+    writeRender(*viewportScene, getRenderImageSettings());
+    viewportJob = RenderJob();
 }
 
 int showViewport()
 {
+    // Progressive, so the render can be stopped at any pass with an evenly
+    // converged image.
+    raytracer::Image image = getRenderImageSettings();
+    image.isProgressive = true;
+    viewportScene = createRenderScene(image);
+
     VulkanRenderer renderer;
     Window window(reinterpret_cast<Renderer *>(&renderer), 1280, 720, "Render Engine");
     window.setRenderListener(onRenderClicked);
+    window.setUpdateListener(onViewportUpdate);
     window.show();
 
+    // A render still running when the window closes is stopped after the
+    // tiles in progress, and written out as far as it got.
+    if (viewportJob.isValid())
+    {
+        viewportJob.cancel();
+        viewportJob.wait();
+        viewportReporter.reset();
+        std::cout << "Stopped after " << viewportJob.getCompletedPasses() << " of "
+                  << viewportJob.getPassCount() << " passes" << std::endl;
+        writeRender(*viewportScene, getRenderImageSettings());
+        viewportJob = RenderJob();
+    }
+    viewportScene.reset();
+
     return 0;
 }
 
 int main(int argc, char **argv)
 {
-#if RENDER_SILENT
+#if BENCHMARK_BVH
+    int status = benchmarkBVH();
+#elif BENCHMARK_TRIANGLE
+    int status = benchmarkTriangleIntersection();
+#elif BENCHMARK_DISPATCH
+    int status = benchmarkDispatch();
+#elif RENDER_SILENT
     int status = renderImage();
 #else
     int status = showViewport();
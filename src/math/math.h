@@ -1,6 +1,7 @@
 #ifndef MATH_H
 #define MATH_H
 
+#include "trig.h"
 #include "vector3.h"
 #include "matrix4.h"
 
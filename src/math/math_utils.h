@@ -2,6 +2,9 @@
 #define MATH_UTILS_H
 
 #include <cmath>
+#include <limits>
+
+#include "random.h"
 
 namespace math
 {
@@ -23,10 +26,11 @@ namespace math
         return x < xMin ? xMin : (x > xMax ? xMax : x);
     }
 
-    // Random number in the range of [0, 1)
+    // Random number in the range of [0, 1), from the generator of the
+    // calling thread.
     inline double random()
     {
-        return static_cast<double>(rand()) / (RAND_MAX + 1.0);
+        return threadRandom().next();
     }
 
     // Random number in the range of [min, max)
@@ -0,0 +1,151 @@
+#include "matrix4.h"
+
+namespace math
+{
+    Matrix4 Matrix4::transpose() const
+    {
+        Matrix4 t;
+        for (int r = 0; r < 4; r++)
+            for (int c = 0; c < 4; c++)
+                t.m[r][c] = m[c][r];
+        return t;
+    }
+
+    /**
+     * @brief Gauss-Jordan elimination with partial pivoting. Singular matrices
+     * return the identity.
+     *
+     * @return Matrix4
+     */
+    Matrix4 Matrix4::inverse() const
+    {
+        double a[4][8];
+        for (int r = 0; r < 4; r++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                a[r][c] = m[r][c];
+                a[r][c + 4] = r == c ? 1.0 : 0.0;
+            }
+        }
+
+        for (int c = 0; c < 4; c++)
+        {
+            int pivot = c;
+            for (int r = c + 1; r < 4; r++)
+                if (std::abs(a[r][c]) > std::abs(a[pivot][c]))
+                    pivot = r;
+
+            if (std::abs(a[pivot][c]) < 1e-12)
+                return Matrix4::identity;
+
+            if (pivot != c)
+                for (int k = 0; k < 8; k++)
+                    std::swap(a[c][k], a[pivot][k]);
+
+            double invPivot = 1.0 / a[c][c];
+            for (int k = 0; k < 8; k++)
+                a[c][k] *= invPivot;
+
+            for (int r = 0; r < 4; r++)
+            {
+                if (r == c || a[r][c] == 0.0)
+                    continue;
+                double f = a[r][c];
+                for (int k = 0; k < 8; k++)
+                    a[r][k] -= f * a[c][k];
+            }
+        }
+
+        Matrix4 inv;
+        for (int r = 0; r < 4; r++)
+            for (int c = 0; c < 4; c++)
+                inv.m[r][c] = a[r][c + 4];
+        return inv;
+    }
+
+    Point Matrix4::transformPoint(const Point &p) const
+    {
+        Point out(m[0][0] * p[0] + m[0][1] * p[1] + m[0][2] * p[2] + m[0][3],
+                  m[1][0] * p[0] + m[1][1] * p[1] + m[1][2] * p[2] + m[1][3],
+                  m[2][0] * p[0] + m[2][1] * p[1] + m[2][2] * p[2] + m[2][3]);
+        double w = m[3][0] * p[0] + m[3][1] * p[1] + m[3][2] * p[2] + m[3][3];
+        if (w != 1.0 && w != 0.0)
+            out /= w;
+        return out;
+    }
+
+    Vector3 Matrix4::transformVector(const Vector3 &v) const
+    {
+        return Vector3(m[0][0] * v[0] + m[0][1] * v[1] + m[0][2] * v[2],
+                       m[1][0] * v[0] + m[1][1] * v[1] + m[1][2] * v[2],
+                       m[2][0] * v[0] + m[2][1] * v[1] + m[2][2] * v[2]);
+    }
+
+    Matrix4 Matrix4::translate(const Vector3 &offset)
+    {
+        return Matrix4(1.0, 0.0, 0.0, offset[0],
+                       0.0, 1.0, 0.0, offset[1],
+                       0.0, 0.0, 1.0, offset[2],
+                       0.0, 0.0, 0.0, 1.0);
+    }
+
+    Matrix4 Matrix4::scale(const Vector3 &factor)
+    {
+        return Matrix4(factor[0], 0.0, 0.0, 0.0,
+                       0.0, factor[1], 0.0, 0.0,
+                       0.0, 0.0, factor[2], 0.0,
+                       0.0, 0.0, 0.0, 1.0);
+    }
+
+    /**
+     * @brief Rotation about an arbitrary axis through the origin (Rodrigues'
+     * rotation formula).
+     *
+     * @return Matrix4
+     */
+    Matrix4 Matrix4::rotate(const Vector3 &axis, double degrees)
+    {
+        Vector3 a = axis.normalize();
+        double rad = degreeToRadians(degrees);
+        double c = cos(rad);
+        double s = sin(rad);
+        double t = 1.0 - c;
+
+        return Matrix4(t * a[0] * a[0] + c, t * a[0] * a[1] - s * a[2], t * a[0] * a[2] + s * a[1], 0.0,
+                       t * a[0] * a[1] + s * a[2], t * a[1] * a[1] + c, t * a[1] * a[2] - s * a[0], 0.0,
+                       t * a[0] * a[2] - s * a[1], t * a[1] * a[2] + s * a[0], t * a[2] * a[2] + c, 0.0,
+                       0.0, 0.0, 0.0, 1.0);
+    }
+
+    // Arithmetic Operations
+    Matrix4 operator*(const Matrix4 &a, const Matrix4 &b)
+    {
+        Matrix4 out;
+        for (int r = 0; r < 4; r++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                out.m[r][c] = a.m[r][0] * b.m[0][c] +
+                              a.m[r][1] * b.m[1][c] +
+                              a.m[r][2] * b.m[2][c] +
+                              a.m[r][3] * b.m[3][c];
+            }
+        }
+        return out;
+    }
+
+    std::ostream &operator<<(std::ostream &out, const Matrix4 &m)
+    {
+        out << '{';
+        for (int r = 0; r < 4; r++)
+        {
+            out << '{' << m.m[r][0] << ", " << m.m[r][1] << ", " << m.m[r][2] << ", " << m.m[r][3] << '}';
+            if (r < 3)
+                out << ", ";
+        }
+        return out << '}';
+    }
+
+    const Matrix4 Matrix4::identity{};
+}
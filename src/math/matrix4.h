@@ -0,0 +1,60 @@
+#ifndef MATRIX4_H
+#define MATRIX4_H
+
+#include <iostream>
+#include "vector3.h"
+
+namespace math
+{
+    /**
+     * @brief Row-major 4x4 matrix for affine transformations. Points and
+     * vectors are treated as column vectors, so transformations compose from
+     * right to left: (A * B) applies B first.
+     */
+    class Matrix4
+    {
+    private:
+        double m[4][4]{{1.0, 0.0, 0.0, 0.0},
+                       {0.0, 1.0, 0.0, 0.0},
+                       {0.0, 0.0, 1.0, 0.0},
+                       {0.0, 0.0, 0.0, 1.0}};
+
+    public:
+        // Constructors
+        Matrix4() = default;
+        Matrix4(double m00, double m01, double m02, double m03,
+                double m10, double m11, double m12, double m13,
+                double m20, double m21, double m22, double m23,
+                double m30, double m31, double m32, double m33)
+            : m{{m00, m01, m02, m03},
+                {m10, m11, m12, m13},
+                {m20, m21, m22, m23},
+                {m30, m31, m32, m33}} {}
+
+        // Access
+        double operator()(int row, int col) const { return m[row][col]; }
+        double &operator()(int row, int col) { return m[row][col]; }
+
+        // Matrix specific operations
+        Matrix4 transpose() const;
+        Matrix4 inverse() const;
+
+        Point transformPoint(const Point &p) const;
+        Vector3 transformVector(const Vector3 &v) const;
+
+        static Matrix4 translate(const Vector3 &offset);
+        static Matrix4 scale(const Vector3 &factor);
+        static Matrix4 rotate(const Vector3 &axis, double degrees);
+
+        // Arithmetic operations
+        friend Matrix4 operator*(const Matrix4 &a, const Matrix4 &b);
+
+        // Other operations
+        friend std::ostream &operator<<(std::ostream &out, const Matrix4 &m);
+
+        // static values
+        static const Matrix4 identity;
+    };
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include "random.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace math
+{
+    namespace
+    {
+        inline uint64_t splitMix64(uint64_t &state)
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        inline uint64_t rotl(uint64_t x, int k)
+        {
+            return (x << k) | (x >> (64 - k));
+        }
+    }
+
+    /**
+     * State is expanded from the seed with SplitMix64, as recommended by the
+     * xoshiro authors. It is never all zero.
+     */
+    void Random::setSeed(uint64_t seed)
+    {
+        uint64_t splitState = seed;
+        for (int lane = 0; lane < LANES; lane++)
+            for (int i = 0; i < 4; i++)
+                m_state[i][lane] = splitMix64(splitState);
+        m_next = BATCH_SIZE;
+    }
+
+    void Random::refill()
+    {
+        uint64_t *s0 = m_state[0];
+        uint64_t *s1 = m_state[1];
+        uint64_t *s2 = m_state[2];
+        uint64_t *s3 = m_state[3];
+
+        for (int step = 0; step < BATCH_SIZE; step += LANES)
+        {
+            uint64_t bits[LANES];
+            for (int lane = 0; lane < LANES; lane++)
+            {
+                bits[lane] = rotl(s0[lane] + s3[lane], 23) + s0[lane];
+
+                uint64_t t = s1[lane] << 17;
+                s2[lane] ^= s0[lane];
+                s3[lane] ^= s1[lane];
+                s1[lane] ^= s2[lane];
+                s0[lane] ^= s3[lane];
+                s2[lane] ^= t;
+                s3[lane] = rotl(s3[lane], 45);
+            }
+
+            for (int lane = 0; lane < LANES; lane++)
+                m_batch[step + lane] = toUnitInterval(bits[lane]);
+        }
+        m_next = 0;
+    }
+
+    void Random::fill(double *out, size_t count)
+    {
+        while (count > 0)
+        {
+            if (m_next == BATCH_SIZE)
+                refill();
+
+            size_t n = std::min(count, static_cast<size_t>(BATCH_SIZE - m_next));
+            std::copy(m_batch + m_next, m_batch + m_next + n, out);
+            m_next += static_cast<int>(n);
+            out += n;
+            count -= n;
+        }
+    }
+
+    uint64_t detail::nextThreadSeed()
+    {
+        static std::atomic<uint64_t> threadCount{0};
+        return threadCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace math
+{
+    /**
+     * @brief Fast pseudo random number generator: xoshiro256++ (Blackman and
+     * Vigna). Four independent generators run side by side in structure of
+     * arrays layout, so refilling a batch is plain 64-bit lane arithmetic the
+     * compiler vectorizes. Numbers are then handed out from the batch.
+     *
+     * Not thread safe. Every thread uses its own generator, see threadRandom().
+     */
+    class Random
+    {
+    public:
+        static constexpr int LANES = 4;
+        // Numbers generated per refill.
+        static constexpr int BATCH_SIZE = 4 * LANES;
+
+    private:
+        uint64_t m_state[4][LANES];
+        double m_batch[BATCH_SIZE];
+        int m_next = BATCH_SIZE;
+
+        void refill();
+
+    public:
+        explicit Random(uint64_t seed = 0) { setSeed(seed); }
+
+        // Restarts the sequence. Equal seeds give equal sequences.
+        void setSeed(uint64_t seed);
+
+        // Random number in the range of [0, 1)
+        inline double next()
+        {
+            if (m_next == BATCH_SIZE)
+                refill();
+            return m_batch[m_next++];
+        }
+
+        // Random number in the range of [min, max)
+        inline double next(double min, double max)
+        {
+            return min + (max - min) * next();
+        }
+
+        // Writes count random numbers in the range of [0, 1).
+        void fill(double *out, size_t count);
+    };
+
+    // Maps 64 random bits to [0, 1). The top 53 bits give every double in
+    // range with a 2^-53 step.
+    inline double toUnitInterval(uint64_t bits)
+    {
+        return static_cast<double>(bits >> 11) * 0x1.0p-53;
+    }
+
+    namespace detail
+    {
+        // Distinct seed for every thread generator.
+        uint64_t nextThreadSeed();
+    }
+
+    // Mixes value into seed. Chain calls to derive a well distributed seed
+    // from several integers, e.g. a pixel and sample index.
+    inline uint64_t hashSeed(uint64_t seed, uint64_t value)
+    {
+        uint64_t z = seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+        // SplitMix64 finalizer.
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Generator of the calling thread, seeded on first use.
+    inline Random &threadRandom()
+    {
+        thread_local Random random(detail::nextThreadSeed());
+        return random;
+    }
+
+    // Restarts the generator of the calling thread.
+    inline void seedRandom(uint64_t seed)
+    {
+        threadRandom().setSeed(seed);
+    }
+}
+
+#endif
@@ -1,143 +1,32 @@
 #include "vector3.h"
+#include "trig.h"
 
 namespace math
 {
-    Vector3::Vector3(const Vector3 &w)
-    {
-        v[0] = w[0];
-        v[1] = w[1];
-        v[2] = w[2];
-    }
-
-    Vector3 &Vector3::operator=(const Vector3 &w)
-    {
-        v[0] = w[0];
-        v[1] = w[1];
-        v[2] = w[2];
-        return *this;
-    }
-
-    Vector3 Vector3::operator-() const
-    {
-        return Vector3(-v[0], -v[1], -v[2]);
-    }
-
-    Vector3 &Vector3::operator+=(const Vector3 &w)
-    {
-        v[0] += w[0];
-        v[1] += w[1];
-        v[2] += w[2];
-
-        return *this;
-    }
-    Vector3 &Vector3::operator-=(const Vector3 &w)
-    {
-        v[0] -= w[0];
-        v[1] -= w[1];
-        v[2] -= w[2];
-        return *this;
-    }
-
-    Vector3 &Vector3::operator*=(const double a)
-    {
-        v[0] *= a;
-        v[1] *= a;
-        v[2] *= a;
-        return *this;
-    }
-
-    Vector3 &Vector3::operator/=(const double a)
-    {
-        return *this *= 1 / a;
-    }
-
-    // Vector specific operations
-    double Vector3::length() const
-    {
-        return sqrt(lengthSquared());
-    }
-
-    double Vector3::lengthSquared() const
-    {
-        return (v[0] * v[0]) + (v[1] * v[1]) + (v[2] * v[2]);
-    }
-
-    Vector3 Vector3::normalize() const
-    {
-        return (*this / length());
-    }
-
-    double Vector3::dot(const Vector3 &v, const Vector3 &w)
-    {
-        return (v[0] * w[0] + v[1] * w[1] + v[2] * w[2]);
-    }
-
-    Vector3 Vector3::cross(const Vector3 &v, const Vector3 &w)
-    {
-        return Vector3(v[1] * w[2] - v[2] * w[1],
-                       v[2] * w[0] - v[0] * w[2],
-                       v[0] * w[1] - v[1] * w[0]);
-    }
-
-    Vector3 Vector3::normalize(const Vector3 &v)
-    {
-        return v / v.length();
-    }
-
-    Vector3 Vector3::lerp(const Vector3 &v, const Vector3 &w, double t)
-    {
-        return (1 - t) * v + t * w;
-    }
-
-    Vector3 Vector3::reflect(const Vector3 &v, const Vector3 &normal)
-    {
-        return v - 2 * dot(v, normal) * normal;
-    }
-
-    // Arithmetic Operations
-    Vector3 operator+(const Vector3 &v, const Vector3 &w)
-    {
-        return Vector3(v[0] + w[0], v[1] + w[1], v[2] + w[2]);
-    }
-
-    Vector3 operator-(const Vector3 &v, const Vector3 &w)
-    {
-        return Vector3(v[0] - w[0], v[1] - w[1], v[2] - w[2]);
-    }
-
-    Vector3 operator*(const Vector3 &v, const Vector3 &w)
-    {
-        return Vector3(v[0] * w[0], v[1] * w[1], v[2] * w[2]);
-    }
-
-    Vector3 operator*(double a, const Vector3 &v)
-    {
-        return Vector3(v[0] * a, v[1] * a, v[2] * a);
-    }
-
-    Vector3 operator*(const Vector3 &v, double a)
-    {
-        return a * v;
-    }
-
-    Vector3 operator/(const Vector3 &v, double a)
+    // Other operations
+    template <typename T>
+    Vector3T<T> Vector3T<T>::random()
     {
-        return (1 / a) * v;
+        double u[3];
+        threadRandom().fill(u, 3);
+        return Vector3T(static_cast<T>(u[0]), static_cast<T>(u[1]), static_cast<T>(u[2]));
     }
 
-    // Other operations
-    Vector3 Vector3::random()
+    template <typename T>
+    Vector3T<T> Vector3T<T>::random(T min, T max)
     {
-        return Vector3(math::random(),
-                       math::random(),
-                       math::random());
+        return random(threadRandom(), min, max);
     }
 
-    Vector3 Vector3::random(double min, double max)
+    template <typename T>
+    Vector3T<T> Vector3T<T>::random(Random &random, T min, T max)
     {
-        return Vector3(math::random(min, max),
-                       math::random(min, max),
-                       math::random(min, max));
+        double u[3];
+        random.fill(u, 3);
+        double range = static_cast<double>(max) - min;
+        return Vector3T(static_cast<T>(min + range * u[0]),
+                        static_cast<T>(min + range * u[1]),
+                        static_cast<T>(min + range * u[2]));
     }
 
     /**
@@ -145,15 +34,12 @@ namespace math
          * 
          * @return Vector3 
          */
-    Vector3 Vector3::randomCircular()
+    template <typename T>
+    Vector3T<T> Vector3T<T>::randomCircular()
     {
-        while (true)
-        {
-            Vector3 randomPt = Vector3(math::random(-1.0, 1.0), math::random(-1.0, 1.0), 0.0);
-            if (randomPt.lengthSquared() >= 1.0)
-                continue;
-            return randomPt;
-        }
+        double u[2];
+        threadRandom().fill(u, 2);
+        return sampleDisk(u[0], u[1]);
     }
 
     /**
@@ -161,40 +47,75 @@ namespace math
          * 
          * @return Vector3 
          */
-    Vector3 Vector3::randomSpherical()
+    template <typename T>
+    Vector3T<T> Vector3T<T>::randomSpherical()
     {
-        double theta = 2 * PI * math::random();
-        double phi = acos(1 - 2 * math::random());
+        double u[2];
+        threadRandom().fill(u, 2);
+        return sampleSpherical(u[0], u[1]);
+    }
 
-        return Vector3(sin(phi) * cos(theta), sin(phi) * sin(theta), cos(phi)).normalize();
+    /**
+     * z = cos(phi) is uniform in [-1, 1] on the unit sphere, so the polar
+     * angle never needs to be computed, and the result is unit length as is.
+     */
+    template <typename T>
+    Vector3T<T> Vector3T<T>::sampleSpherical(double u, double v)
+    {
+        double z = 1.0 - 2.0 * v;
+        double r = std::sqrt(std::fmax(0.0, 1.0 - z * z));
+        double sinTheta, cosTheta;
+        sinCos2Pi(u, sinTheta, cosTheta);
+
+        return Vector3T(static_cast<T>(r * cosTheta), static_cast<T>(r * sinTheta), static_cast<T>(z));
     }
 
-    Vector3 Vector3::randomHemiSpherical(const Vector3 &normal)
+    /**
+     * Shirley and Chiu's concentric mapping takes squares around the centre
+     * of [-1, 1]^2 to circles, so strata stay compact and neighbouring
+     * samples stay neighbours, unlike the polar mapping. The wedge is
+     * picked with selects instead of branches.
+     */
+    template <typename T>
+    Vector3T<T> Vector3T<T>::sampleDisk(double u, double v)
     {
-        Vector3 rand = Vector3::randomSpherical();
-        if (Vector3::dot(rand, normal) > 0.0)
-            return rand;
-        else
-            return -rand;
+        double a = 2.0 * u - 1.0;
+        double b = 2.0 * v - 1.0;
+
+        bool isHorizontal = a * a > b * b;
+        double r = isHorizontal ? a : b;
+        double ratio = r != 0.0 ? (isHorizontal ? b : a) / r : 0.0;
+        // Angle in turns: pi/4 * b/a, or pi/2 - pi/4 * a/b.
+        double turns = isHorizontal ? 0.125 * ratio : 0.25 - 0.125 * ratio;
+
+        double sinTheta, cosTheta;
+        sinCos2Pi(turns, sinTheta, cosTheta);
+        return Vector3T(static_cast<T>(r * cosTheta), static_cast<T>(r * sinTheta), 0);
     }
 
-    std::ostream &operator<<(std::ostream &out, const Vector3 &v)
+    // Malley's method: points spread evenly over the disk, lifted onto the
+    // hemisphere, are distributed with the cosine.
+    template <typename T>
+    Vector3T<T> Vector3T<T>::sampleCosineHemisphere(double u, double v)
     {
-        return out << '{' << v[0] << ", " << v[1] << ", " << v[2] << '}';
+        Vector3T disk = sampleDisk(u, v);
+        double z = std::sqrt(std::fmax(0.0, 1.0 - disk.x() * disk.x() - disk.y() * disk.y()));
+        return Vector3T(disk.x(), disk.y(), static_cast<T>(z));
     }
 
-    // Comparison operations
-    bool operator==(const Vector3 &v, const Vector3 &w)
+    template <typename T>
+    Vector3T<T> Vector3T<T>::randomHemiSpherical(const Vector3T &normal)
     {
-        return std::abs(v.length() - w.length()) <= std::numeric_limits<float>::epsilon();
+        Vector3T rand = Vector3T::randomSpherical();
+        if (Vector3T::dot(rand, normal) > 0)
+            return rand;
+        else
+            return -rand;
     }
 
-    const Vector3 Vector3::zero{0.0, 0.0, 0.0};
-    const Vector3 Vector3::one{1.0, 1.0, 1.0};
-    const Vector3 Vector3::up{0.0, 1.0, 0.0};
-    const Vector3 Vector3::down{0.0, -1.0, 0.0};
-    const Vector3 Vector3::left{-1.0, 0.0, 0.0};
-    const Vector3 Vector3::right{1.0, 0.0, 0.0};
-    const Vector3 Vector3::forward{0.0, 0.0, 1.0};
-    const Vector3 Vector3::back{0.0, 0.0, -1.0};
+    template class Vector3T<float>;
+    template class Vector3T<double>;
+
+    static_assert(std::is_trivially_copyable<Vector3f>::value && sizeof(Vector3f) == 16, "Vector3f must fill one SSE register");
+    static_assert(std::is_trivially_copyable<Vector3d>::value && sizeof(Vector3d) == 32, "Vector3d must fill one AVX register");
 }
@@ -1,96 +1,452 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
+#include <cstddef>
+#include <functional>
 #include <iostream>
+#include <type_traits>
 #include "math_utils.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define MATH_SSE 1
+#endif
+
+#if defined(__AVX__)
+#define MATH_AVX 1
+#endif
+
 namespace math
 {
-    class Vector3
+    namespace detail
+    {
+        /**
+         * @brief Lane wise operations on the four lane storage of Vector3T.
+         * The fourth lane is padding. It starts at 0, so whole registers can
+         * be loaded, but it is not kept at 0: scaling or multiplying by an
+         * infinity turns it into NaN. Dot products therefore leave it out.
+         * Results may alias the inputs. Specialized with SSE for float, and with AVX for double
+         * when enabled or else with SSE2 on two register halves.
+         */
+        template <typename T>
+        struct VectorOps
+        {
+            static inline void add(const T *a, const T *b, T *r)
+            {
+                for (int i = 0; i < 4; i++)
+                    r[i] = a[i] + b[i];
+            }
+
+            static inline void sub(const T *a, const T *b, T *r)
+            {
+                for (int i = 0; i < 4; i++)
+                    r[i] = a[i] - b[i];
+            }
+
+            static inline void mul(const T *a, const T *b, T *r)
+            {
+                for (int i = 0; i < 4; i++)
+                    r[i] = a[i] * b[i];
+            }
+
+            static inline void scale(const T *a, T s, T *r)
+            {
+                for (int i = 0; i < 4; i++)
+                    r[i] = a[i] * s;
+            }
+
+            static inline T dot(const T *a, const T *b)
+            {
+                return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+            }
+
+            static inline void cross(const T *a, const T *b, T *r)
+            {
+                T x = a[1] * b[2] - a[2] * b[1];
+                T y = a[2] * b[0] - a[0] * b[2];
+                T z = a[0] * b[1] - a[1] * b[0];
+                r[0] = x;
+                r[1] = y;
+                r[2] = z;
+                r[3] = 0;
+            }
+        };
+
+#if MATH_SSE
+        template <>
+        struct VectorOps<float>
+        {
+            static inline void add(const float *a, const float *b, float *r)
+            {
+                _mm_store_ps(r, _mm_add_ps(_mm_load_ps(a), _mm_load_ps(b)));
+            }
+
+            static inline void sub(const float *a, const float *b, float *r)
+            {
+                _mm_store_ps(r, _mm_sub_ps(_mm_load_ps(a), _mm_load_ps(b)));
+            }
+
+            static inline void mul(const float *a, const float *b, float *r)
+            {
+                _mm_store_ps(r, _mm_mul_ps(_mm_load_ps(a), _mm_load_ps(b)));
+            }
+
+            static inline void scale(const float *a, float s, float *r)
+            {
+                _mm_store_ps(r, _mm_mul_ps(_mm_load_ps(a), _mm_set1_ps(s)));
+            }
+
+            static inline float dot(const float *a, const float *b)
+            {
+                __m128 m = _mm_mul_ps(_mm_load_ps(a), _mm_load_ps(b));
+                m = _mm_and_ps(m, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+                __m128 sum = _mm_add_ps(m, _mm_movehl_ps(m, m));
+                sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+                return _mm_cvtss_f32(sum);
+            }
+
+            // a * b.yzx - a.yzx * b is the cross product in zxy order.
+            static inline void cross(const float *a, const float *b, float *r)
+            {
+                __m128 va = _mm_load_ps(a);
+                __m128 vb = _mm_load_ps(b);
+                __m128 aYZX = _mm_shuffle_ps(va, va, _MM_SHUFFLE(3, 0, 2, 1));
+                __m128 bYZX = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(3, 0, 2, 1));
+                __m128 c = _mm_sub_ps(_mm_mul_ps(va, bYZX), _mm_mul_ps(aYZX, vb));
+                _mm_store_ps(r, _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+            }
+        };
+#endif
+
+#if MATH_AVX
+        template <>
+        struct VectorOps<double>
+        {
+            static inline void add(const double *a, const double *b, double *r)
+            {
+                _mm256_store_pd(r, _mm256_add_pd(_mm256_load_pd(a), _mm256_load_pd(b)));
+            }
+
+            static inline void sub(const double *a, const double *b, double *r)
+            {
+                _mm256_store_pd(r, _mm256_sub_pd(_mm256_load_pd(a), _mm256_load_pd(b)));
+            }
+
+            static inline void mul(const double *a, const double *b, double *r)
+            {
+                _mm256_store_pd(r, _mm256_mul_pd(_mm256_load_pd(a), _mm256_load_pd(b)));
+            }
+
+            static inline void scale(const double *a, double s, double *r)
+            {
+                _mm256_store_pd(r, _mm256_mul_pd(_mm256_load_pd(a), _mm256_set1_pd(s)));
+            }
+
+            static inline double dot(const double *a, const double *b)
+            {
+                __m256d m = _mm256_mul_pd(_mm256_load_pd(a), _mm256_load_pd(b));
+                m = _mm256_blend_pd(m, _mm256_setzero_pd(), 0x8);
+                __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(m), _mm256_extractf128_pd(m, 1));
+                sum = _mm_add_sd(sum, _mm_unpackhi_pd(sum, sum));
+                return _mm_cvtsd_f64(sum);
+            }
+
+            static inline void cross(const double *a, const double *b, double *r)
+            {
+#if defined(__AVX2__)
+                __m256d va = _mm256_load_pd(a);
+                __m256d vb = _mm256_load_pd(b);
+                __m256d aYZX = _mm256_permute4x64_pd(va, _MM_SHUFFLE(3, 0, 2, 1));
+                __m256d bYZX = _mm256_permute4x64_pd(vb, _MM_SHUFFLE(3, 0, 2, 1));
+                __m256d c = _mm256_sub_pd(_mm256_mul_pd(va, bYZX), _mm256_mul_pd(aYZX, vb));
+                _mm256_store_pd(r, _mm256_permute4x64_pd(c, _MM_SHUFFLE(3, 0, 2, 1)));
+#else
+                // Lane permutes across 128-bit halves need AVX2.
+                double x = a[1] * b[2] - a[2] * b[1];
+                double y = a[2] * b[0] - a[0] * b[2];
+                double z = a[0] * b[1] - a[1] * b[0];
+                r[0] = x;
+                r[1] = y;
+                r[2] = z;
+                r[3] = 0.0;
+#endif
+            }
+        };
+#elif MATH_SSE
+        /**
+         * The default build, since AVX stays off on the MinGW toolchain.
+         * Lanes xy and zw are held in two SSE2 registers. Only 16 byte
+         * alignment is assumed, which the stack always provides.
+         */
+        template <>
+        struct VectorOps<double>
+        {
+            static inline void add(const double *a, const double *b, double *r)
+            {
+                _mm_store_pd(r, _mm_add_pd(_mm_load_pd(a), _mm_load_pd(b)));
+                _mm_store_pd(r + 2, _mm_add_pd(_mm_load_pd(a + 2), _mm_load_pd(b + 2)));
+            }
+
+            static inline void sub(const double *a, const double *b, double *r)
+            {
+                _mm_store_pd(r, _mm_sub_pd(_mm_load_pd(a), _mm_load_pd(b)));
+                _mm_store_pd(r + 2, _mm_sub_pd(_mm_load_pd(a + 2), _mm_load_pd(b + 2)));
+            }
+
+            static inline void mul(const double *a, const double *b, double *r)
+            {
+                _mm_store_pd(r, _mm_mul_pd(_mm_load_pd(a), _mm_load_pd(b)));
+                _mm_store_pd(r + 2, _mm_mul_pd(_mm_load_pd(a + 2), _mm_load_pd(b + 2)));
+            }
+
+            static inline void scale(const double *a, double s, double *r)
+            {
+                __m128d vs = _mm_set1_pd(s);
+                _mm_store_pd(r, _mm_mul_pd(_mm_load_pd(a), vs));
+                _mm_store_pd(r + 2, _mm_mul_pd(_mm_load_pd(a + 2), vs));
+            }
+
+            // Summed as (x + y) + z, like the scalar version, so results
+            // do not depend on the path.
+            static inline double dot(const double *a, const double *b)
+            {
+                __m128d xy = _mm_mul_pd(_mm_load_pd(a), _mm_load_pd(b));
+                __m128d zw = _mm_mul_pd(_mm_load_pd(a + 2), _mm_load_pd(b + 2));
+                __m128d sum = _mm_add_sd(xy, _mm_unpackhi_pd(xy, xy));
+                return _mm_cvtsd_f64(_mm_add_sd(sum, zw));
+            }
+
+            // Same as the float version, with the yzx rotation done across
+            // the two halves: (y, z) and (x, 0).
+            static inline void cross(const double *a, const double *b, double *r)
+            {
+                __m128d aXY = _mm_load_pd(a);
+                __m128d aZW = _mm_load_pd(a + 2);
+                __m128d bXY = _mm_load_pd(b);
+                __m128d bZW = _mm_load_pd(b + 2);
+                __m128d aYZ = _mm_shuffle_pd(aXY, aZW, 1);
+                __m128d aXW = _mm_shuffle_pd(aXY, aZW, 2);
+                __m128d bYZ = _mm_shuffle_pd(bXY, bZW, 1);
+                __m128d bXW = _mm_shuffle_pd(bXY, bZW, 2);
+                // Cross product in zxy order.
+                __m128d cZX = _mm_sub_pd(_mm_mul_pd(aXY, bYZ), _mm_mul_pd(aYZ, bXY));
+                __m128d cYW = _mm_sub_pd(_mm_mul_pd(aZW, bXW), _mm_mul_pd(aXW, bZW));
+                _mm_store_pd(r, _mm_shuffle_pd(cZX, cYW, 1));
+                _mm_store_pd(r + 2, _mm_shuffle_pd(cZX, cYW, 2));
+            }
+        };
+#endif
+    }
+
+    /**
+     * @brief 3D vector of float or double components. Stored in four lanes,
+     * the last one padding, and aligned to the full width, so it is trivially
+     * copyable and maps directly onto an SSE (float) or AVX (double)
+     * register, or two SSE2 registers for double without AVX.
+     */
+    template <typename T>
+    class alignas(4 * sizeof(T)) Vector3T
     {
+        static_assert(std::is_floating_point<T>::value, "Vector3T needs float or double components");
+
     private:
-        double v[3]{0, 0, 0};
+        T v[4]{0, 0, 0, 0};
+
+        using Ops = detail::VectorOps<T>;
 
     public:
-        // Constructors
-        Vector3() = default;
-        Vector3(double x = 0.0, double y = 0.0, double z = 0.0) : v{x, y, z} {}
+        using Scalar = T;
 
-        // Access and assigments
-        Vector3(const Vector3 &w);
-        Vector3 &operator=(const Vector3 &w);
+        // Constructors
+        constexpr Vector3T() = default;
+        constexpr Vector3T(T x, T y = 0, T z = 0) : v{x, y, z, 0} {}
 
-        double &x = v[0];
-        double &y = v[1];
-        double &z = v[2];
+        // Access
+        T x() const { return v[0]; }
+        T y() const { return v[1]; }
+        T z() const { return v[2]; }
+        T &x() { return v[0]; }
+        T &y() { return v[1]; }
+        T &z() { return v[2]; }
 
-        double operator[](int i) const { return v[i]; }
-        double &operator[](int i) { return v[i]; }
+        T operator[](int i) const { return v[i]; }
+        T &operator[](int i) { return v[i]; }
+        const T *data() const { return v; }
 
         // Current Vector operations
-        Vector3 operator-() const;
-        Vector3 &operator+=(const Vector3 &w);
-        Vector3 &operator-=(const Vector3 &w);
-        Vector3 &operator*=(const double a);
-        Vector3 &operator/=(const double a);
+        inline Vector3T operator-() const
+        {
+            Vector3T r;
+            Ops::scale(v, T(-1), r.v);
+            return r;
+        }
+
+        inline Vector3T &operator+=(const Vector3T &w)
+        {
+            Ops::add(v, w.v, v);
+            return *this;
+        }
+
+        inline Vector3T &operator-=(const Vector3T &w)
+        {
+            Ops::sub(v, w.v, v);
+            return *this;
+        }
+
+        inline Vector3T &operator*=(const T a)
+        {
+            Ops::scale(v, a, v);
+            return *this;
+        }
+
+        inline Vector3T &operator/=(const T a)
+        {
+            return *this *= T(1) / a;
+        }
 
         // Vector Specific operataions
-        double length() const;
-        double lengthSquared() const;
-        Vector3 normalize() const;
+        inline T length() const { return std::sqrt(lengthSquared()); }
+        inline T lengthSquared() const { return Ops::dot(v, v); }
+        inline Vector3T normalize() const { return *this / length(); }
 
-        static double dot(const Vector3 &v, const Vector3 &w);
-        static Vector3 cross(const Vector3 &v, const Vector3 &w);
-        static Vector3 normalize(const Vector3 &v);
-        static Vector3 lerp(const Vector3 &v, const Vector3 &w, double t);
-        static Vector3 reflect(const Vector3 &v, const Vector3 &normal);
+        static inline T dot(const Vector3T &v, const Vector3T &w) { return Ops::dot(v.v, w.v); }
+
+        static inline Vector3T cross(const Vector3T &v, const Vector3T &w)
+        {
+            Vector3T r;
+            Ops::cross(v.v, w.v, r.v);
+            return r;
+        }
+
+        static inline Vector3T normalize(const Vector3T &v) { return v / v.length(); }
+        static inline Vector3T lerp(const Vector3T &v, const Vector3T &w, T t) { return (1 - t) * v + t * w; }
+        static inline Vector3T reflect(const Vector3T &v, const Vector3T &normal) { return v - 2 * dot(v, normal) * normal; }
+
+        // Completes the unit vector normal to a right handed orthonormal
+        // basis, without branches (Duff et al., 2017).
+        static inline void orthonormalBasis(const Vector3T &normal, Vector3T &tangent, Vector3T &bitangent)
+        {
+            T sign = std::copysign(T(1), normal.z());
+            T a = T(-1) / (sign + normal.z());
+            T b = normal.x() * normal.y() * a;
+            tangent = Vector3T(1 + sign * normal.x() * normal.x() * a, sign * b, -sign * normal.x());
+            bitangent = Vector3T(b, sign + normal.y() * normal.y() * a, -normal.y());
+        }
 
         // Arithmetic operations
-        friend Vector3 operator+(const Vector3 &v, const Vector3 &w);
-        friend Vector3 operator-(const Vector3 &v, const Vector3 &w);
-        friend Vector3 operator*(const Vector3 &v, const Vector3 &w);
-        friend Vector3 operator*(const Vector3 &v, double a);
-        friend Vector3 operator*(double a, const Vector3 &v);
-        friend Vector3 operator/(const Vector3 &v, double a);
+        friend inline Vector3T operator+(const Vector3T &v, const Vector3T &w)
+        {
+            Vector3T r;
+            Ops::add(v.v, w.v, r.v);
+            return r;
+        }
+
+        friend inline Vector3T operator-(const Vector3T &v, const Vector3T &w)
+        {
+            Vector3T r;
+            Ops::sub(v.v, w.v, r.v);
+            return r;
+        }
+
+        friend inline Vector3T operator*(const Vector3T &v, const Vector3T &w)
+        {
+            Vector3T r;
+            Ops::mul(v.v, w.v, r.v);
+            return r;
+        }
+
+        friend inline Vector3T operator*(const Vector3T &v, T a)
+        {
+            Vector3T r;
+            Ops::scale(v.v, a, r.v);
+            return r;
+        }
+
+        friend inline Vector3T operator*(T a, const Vector3T &v) { return v * a; }
+        friend inline Vector3T operator/(const Vector3T &v, T a) { return v * (T(1) / a); }
 
         // Other operations
-        static Vector3 random();
-        static Vector3 random(double min, double max);
-        static Vector3 randomCircular();
-        static Vector3 randomSpherical();
-        static Vector3 randomHemiSpherical(const Vector3 &normal);
-        friend std::ostream &operator<<(std::ostream &out, const Vector3 &v);
+        static Vector3T random();
+        static Vector3T random(T min, T max);
+        static Vector3T random(Random &random, T min, T max);
+        static Vector3T randomCircular();
+        static Vector3T randomSpherical();
+        // Point on the unit sphere from two uniform numbers in [0, 1). Maps
+        // evenly spread numbers to evenly spread points.
+        static Vector3T sampleSpherical(double u, double v);
+        // Point in the unit disk of the xy plane, from two uniform numbers
+        // in [0, 1), with the concentric mapping.
+        static Vector3T sampleDisk(double u, double v);
+        // Direction in the hemisphere around +z, with density cos / pi.
+        static Vector3T sampleCosineHemisphere(double u, double v);
+        static Vector3T randomHemiSpherical(const Vector3T &normal);
+
+        friend std::ostream &operator<<(std::ostream &out, const Vector3T &v)
+        {
+            return out << '{' << v[0] << ", " << v[1] << ", " << v[2] << '}';
+        }
 
         // Comparison operations
-        friend bool operator==(const Vector3 &v, const Vector3 &w);
+        friend bool operator==(const Vector3T &v, const Vector3T &w)
+        {
+            return std::abs(v.length() - w.length()) <= std::numeric_limits<float>::epsilon();
+        }
 
         // static values
-        static const Vector3 zero;
-        static const Vector3 one;
-        static const Vector3 up;
-        static const Vector3 down;
-        static const Vector3 left;
-        static const Vector3 right;
-        static const Vector3 forward;
-        static const Vector3 back;
+        static const Vector3T zero;
+        static const Vector3T one;
+        static const Vector3T up;
+        static const Vector3T down;
+        static const Vector3T left;
+        static const Vector3T right;
+        static const Vector3T forward;
+        static const Vector3T back;
     };
 
+    template <typename T>
+    const Vector3T<T> Vector3T<T>::zero(0, 0, 0);
+    template <typename T>
+    const Vector3T<T> Vector3T<T>::one(1, 1, 1);
+    template <typename T>
+    const Vector3T<T> Vector3T<T>::up(0, 1, 0);
+    template <typename T>
+    const Vector3T<T> Vector3T<T>::down(0, -1, 0);
+    template <typename T>
+    const Vector3T<T> Vector3T<T>::left(-1, 0, 0);
+    template <typename T>
+    const Vector3T<T> Vector3T<T>::right(1, 0, 0);
+    template <typename T>
+    const Vector3T<T> Vector3T<T>::forward(0, 0, 1);
+    template <typename T>
+    const Vector3T<T> Vector3T<T>::back(0, 0, -1);
+
+    using Vector3f = Vector3T<float>;
+    using Vector3d = Vector3T<double>;
+
+    // Precision of the vectors used by the renderer. Define
+    // MATH_SINGLE_PRECISION to switch from double to float.
+#ifdef MATH_SINGLE_PRECISION
+    using Vector3 = Vector3f;
+#else
+    using Vector3 = Vector3d;
+#endif
+
     using Point = Vector3;
     using Color = Vector3;
 }
 
 namespace std
 {
-    template <>
-    struct hash<math::Vector3>
+    template <typename T>
+    struct hash<math::Vector3T<T>>
     {
-        size_t operator()(math::Vector3 const &vector3) const
+        size_t operator()(math::Vector3T<T> const &vector3) const
         {
-            return ((hash<double>()(vector3.x) ^
-                     (hash<double>()(vector3.y) << 1)) >>
+            return ((hash<T>()(vector3.x()) ^
+                     (hash<T>()(vector3.y()) << 1)) >>
                     1) ^
-                   (hash<double>()(vector3.z) << 1);
+                   (hash<T>()(vector3.z()) << 1);
         }
     };
 }
-#endif
\ No newline at end of file
+#endif
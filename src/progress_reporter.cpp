@@ -0,0 +1,83 @@
+#include "progress_reporter.h"
+
+#include <iomanip>
+#include <sstream>
+
+ProgressReporter::ProgressReporter(RenderJob job, double intervalSeconds, std::ostream &out)
+    : m_job{std::move(job)},
+      m_interval{intervalSeconds},
+      m_out{out},
+      m_thread{&ProgressReporter::run, this}
+{
+}
+
+ProgressReporter::~ProgressReporter()
+{
+    stop();
+}
+
+std::string ProgressReporter::format(const RenderStats &stats, double raysPerSecond)
+{
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1);
+    if (stats.tileCount > 0)
+        line << 100.0 * stats.tiles / stats.tileCount << "% ";
+    line << stats.tiles << "/" << stats.tileCount << " tiles, "
+         << std::setprecision(2) << raysPerSecond / 1e6 << " Mrays/s, ";
+
+    double eta = stats.getEtaSeconds();
+    line << std::setprecision(1);
+    if (eta < 0.0)
+        line << "ETA unknown";
+    else
+        line << "ETA " << eta << "s";
+    return line.str();
+}
+
+// Throughput is taken over the last interval rather than since the start,
+// so it follows the cost of the part of the image being rendered.
+void ProgressReporter::run()
+{
+    RenderStats previous;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_stopRequested.wait_for(lock, m_interval, [this]
+                                         { return m_isStopping; }))
+                return;
+        }
+
+        RenderStats stats = m_job.getStats();
+        double interval = stats.elapsedSeconds - previous.elapsedSeconds;
+        double raysPerSecond = interval > 0.0 ? (stats.rays - previous.rays) / interval : 0.0;
+        m_out << format(stats, raysPerSecond) << std::endl;
+        previous = stats;
+
+        if (m_job.isDone())
+            return;
+    }
+}
+
+void ProgressReporter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_isStopping)
+            return;
+        m_isStopping = true;
+    }
+    m_stopRequested.notify_all();
+    m_thread.join();
+
+    if (m_job.isDone())
+    {
+        RenderStats stats = m_job.getStats();
+        std::ostringstream summary;
+        summary << std::fixed << std::setprecision(2)
+                << "Rendered " << stats.tiles << "/" << stats.tileCount << " tiles, "
+                << stats.samples << " samples and " << stats.rays << " rays in " << stats.elapsedSeconds << "s, "
+                << stats.getRaysPerSecond() / 1e6 << " Mrays/s";
+        m_out << summary.str() << std::endl;
+    }
+}
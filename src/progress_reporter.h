@@ -0,0 +1,50 @@
+#ifndef PROGRESS_REPORTER_H
+#define PROGRESS_REPORTER_H
+
+#include "render_job.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Prints the progress of a render from a thread of its own at a
+ * fixed interval: tiles done, throughput since the last report in Mrays/s
+ * and the ETA. It only polls RenderJob::getStats, so the workers never
+ * wait on it.
+ *
+ * Reports until the job is done or stop() is called.
+ */
+class ProgressReporter
+{
+private:
+    RenderJob m_job;
+    std::chrono::duration<double> m_interval;
+    std::ostream &m_out;
+
+    std::mutex m_mutex;
+    std::condition_variable m_stopRequested;
+    bool m_isStopping = false;
+    std::thread m_thread;
+
+    void run();
+
+public:
+    ProgressReporter(RenderJob job, double intervalSeconds = 1.0, std::ostream &out = std::cout);
+    ~ProgressReporter();
+
+    ProgressReporter(const ProgressReporter &) = delete;
+    ProgressReporter &operator=(const ProgressReporter &) = delete;
+
+    // Stops reporting and joins the thread. If the job is done, prints a
+    // summary of the whole render first.
+    void stop();
+
+    // One report line, with throughput measured over the last interval.
+    static std::string format(const RenderStats &stats, double raysPerSecond);
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include "../../math/math.h"
+#include "../utils/ray.h"
+
+#include <algorithm>
+
+namespace raytracer
+{
+    using math::Point;
+    using math::Vector3;
+
+    /**
+     * @brief Axis aligned bounding box. A default constructed box is empty
+     * (min > max), so that expanding it by any point or box yields that point
+     * or box.
+     */
+    struct AABB
+    {
+        Point min = Point(math::INIFINITY, math::INIFINITY, math::INIFINITY);
+        Point max = Point(-math::INIFINITY, -math::INIFINITY, -math::INIFINITY);
+
+        AABB() = default;
+        AABB(const Point &minPoint, const Point &maxPoint)
+            : min{minPoint}, max{maxPoint} {}
+
+        inline void expand(const Point &p)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                min[i] = std::min(min[i], p[i]);
+                max[i] = std::max(max[i], p[i]);
+            }
+        }
+
+        inline void expand(const AABB &box)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                min[i] = std::min(min[i], box.min[i]);
+                max[i] = std::max(max[i], box.max[i]);
+            }
+        }
+
+        // Shrinks the box to its overlap with box.
+        inline void clip(const AABB &box)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                min[i] = std::max(min[i], box.min[i]);
+                max[i] = std::min(max[i], box.max[i]);
+            }
+        }
+
+        inline bool isEmpty() const
+        {
+            return min[0] > max[0] || min[1] > max[1] || min[2] > max[2];
+        }
+
+        inline Point centroid() const
+        {
+            return Point((min[0] + max[0]) * 0.5, (min[1] + max[1]) * 0.5, (min[2] + max[2]) * 0.5);
+        }
+
+        inline Vector3 extent() const
+        {
+            return max - min;
+        }
+
+        inline double surfaceArea() const
+        {
+            if (isEmpty())
+                return 0.0;
+            Vector3 e = extent();
+            return 2.0 * (e[0] * e[1] + e[1] * e[2] + e[2] * e[0]);
+        }
+
+        // Axis with the largest extent. 0 = x, 1 = y, 2 = z.
+        inline int largestAxis() const
+        {
+            Vector3 e = extent();
+            if (e[0] > e[1] && e[0] > e[2])
+                return 0;
+            return e[1] > e[2] ? 1 : 2;
+        }
+
+        /**
+         * Slab test. invDir is the component-wise reciprocal of the ray
+         * direction, precomputed once per ray. On a hit, tEntry holds the
+         * distance at which the ray enters the box.
+         */
+        inline bool isHit(const Ray &ray, const Vector3 &invDir, double tMin, double tMax, double &tEntry) const
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                double t0 = (min[i] - ray.origin[i]) * invDir[i];
+                double t1 = (max[i] - ray.origin[i]) * invDir[i];
+                if (invDir[i] < 0.0)
+                    std::swap(t0, t1);
+                tMin = t0 > tMin ? t0 : tMin;
+                tMax = t1 < tMax ? t1 : tMax;
+                if (tMax < tMin)
+                    return false;
+            }
+            tEntry = tMin;
+            return true;
+        }
+    };
+}
+
+#endif
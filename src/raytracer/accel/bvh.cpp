@@ -0,0 +1,361 @@
+#include "bvh.h"
+#include "../../utils/parallel.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <numeric>
+
+using namespace raytracer;
+
+void BVH::build(const std::vector<AABB> &primBounds, const BVHSettings &settings,
+                const PrimitiveSplitFunc &splitPrimitive)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    m_settings = settings;
+    m_settings.maxLeafSize = std::max(1, m_settings.maxLeafSize);
+    m_settings.numBins = std::max(2, m_settings.numBins);
+
+    m_settings.numThreads = std::max(1, m_settings.numThreads);
+    m_settings.spatialSplitBudget = std::max(0.0, m_settings.spatialSplitBudget);
+
+    m_nodes.clear();
+    m_primIndices.clear();
+    m_parents.clear();
+    m_stats = BVHStats();
+
+    uint32_t primCount = static_cast<uint32_t>(primBounds.size());
+    if (primCount == 0)
+        return;
+
+    if (m_settings.builder == BVHBuilder::LBVH || (m_settings.builder == BVHBuilder::SBVH && splitPrimitive))
+    {
+        if (m_settings.builder == BVHBuilder::LBVH)
+            buildLinear(primBounds);
+        else
+            buildSpatial(primBounds, splitPrimitive);
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        computeStats(primCount);
+        m_stats.buildTimeMs = elapsed.count();
+        return;
+    }
+
+    std::vector<BuildPrimitive> prims(primCount);
+    for (uint32_t i = 0; i < primCount; i++)
+    {
+        prims[i].bounds = primBounds[i];
+        // Empty bounds (e.g. a mesh without triangles) never get hit, but
+        // still need a finite centroid for binning.
+        prims[i].centroid = primBounds[i].isEmpty() ? Point::zero : primBounds[i].centroid();
+    }
+
+    m_primIndices.resize(primCount);
+    std::iota(m_primIndices.begin(), m_primIndices.end(), 0);
+
+    // A binary tree with N leaves has 2N - 1 nodes. Reserving up front keeps
+    // node references stable while subdividing.
+    m_nodes.reserve(2 * primCount);
+    m_nodes.emplace_back();
+    m_nodes[0].leftFirst = 0;
+    m_nodes[0].count = primCount;
+    updateNodeBounds(0, prims);
+    subdivide(0, 0, prims);
+
+    m_nodes.shrink_to_fit();
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    computeStats(primCount);
+    m_stats.buildTimeMs = elapsed.count();
+}
+
+double BVH::refit(const std::vector<AABB> &primBounds)
+{
+    if (m_nodes.empty())
+        return 1.0;
+
+    auto start = std::chrono::steady_clock::now();
+    const uint32_t nodeCount = static_cast<uint32_t>(m_nodes.size());
+
+    if (m_parents.size() != nodeCount)
+    {
+        m_parents.assign(nodeCount, 0);
+        for (uint32_t i = 0; i < nodeCount; i++)
+        {
+            if (!m_nodes[i].isLeaf())
+            {
+                m_parents[m_nodes[i].leftFirst] = i;
+                m_parents[m_nodes[i].leftFirst + 1] = i;
+            }
+        }
+    }
+
+    // Every leaf walks up towards the root. The first child to arrive at an
+    // interior node stops there; the second one merges both children, which
+    // are final by then, and continues.
+    std::unique_ptr<std::atomic<uint32_t>[]> visits(new std::atomic<uint32_t>[nodeCount]);
+    for (uint32_t i = 0; i < nodeCount; i++)
+        visits[i].store(0, std::memory_order_relaxed);
+
+    parallelFor(m_settings.numThreads, nodeCount, [&](uint32_t begin, uint32_t end, int)
+                {
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        Node &leaf = m_nodes[i];
+                        if (!leaf.isLeaf())
+                            continue;
+
+                        AABB bounds;
+                        for (uint32_t p = leaf.leftFirst; p < leaf.leftFirst + leaf.count; p++)
+                            bounds.expand(primBounds[m_primIndices[p]]);
+                        leaf.bounds = bounds;
+
+                        uint32_t n = i;
+                        while (n != 0)
+                        {
+                            uint32_t parent = m_parents[n];
+                            if (visits[parent].fetch_add(1, std::memory_order_acq_rel) == 0)
+                                break;
+
+                            Node &node = m_nodes[parent];
+                            AABB merged = m_nodes[node.leftFirst].bounds;
+                            merged.expand(m_nodes[node.leftFirst + 1].bounds);
+                            node.bounds = merged;
+                            n = parent;
+                        }
+                    } });
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    m_stats.sahCost = computeSAHCost();
+    m_stats.refitCount++;
+    m_stats.refitTimeMs = elapsed.count();
+
+    return m_builtSahCost > 0.0 ? m_stats.sahCost / m_builtSahCost : 1.0;
+}
+
+void BVH::updateNodeBounds(uint32_t nodeIndex, const std::vector<BuildPrimitive> &prims)
+{
+    Node &node = m_nodes[nodeIndex];
+    node.bounds = AABB();
+    for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+        node.bounds.expand(prims[m_primIndices[i]].bounds);
+}
+
+/**
+ * Evaluates the SAH cost of splitting the node's primitives into two groups
+ * at the boundaries of numBins equally sized bins along each axis of the
+ * centroid bounds. Returns the lowest cost found, or infinity when the
+ * centroids cannot be separated (axis is then set to -1).
+ */
+double BVH::findBestSplit(const Node &node, const std::vector<BuildPrimitive> &prims, int &axis, double &splitPos) const
+{
+    struct Bin
+    {
+        AABB bounds;
+        uint32_t count = 0;
+    };
+
+    const int numBins = m_settings.numBins;
+    std::vector<Bin> bins(numBins);
+    std::vector<double> leftArea(numBins - 1);
+    std::vector<uint32_t> leftCount(numBins - 1);
+
+    AABB centroidBounds;
+    for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+        centroidBounds.expand(prims[m_primIndices[i]].centroid);
+
+    double bestCost = math::INIFINITY;
+    axis = -1;
+
+    for (int a = 0; a < 3; a++)
+    {
+        double boundsMin = centroidBounds.min[a];
+        double boundsMax = centroidBounds.max[a];
+        if (boundsMax <= boundsMin)
+            continue;
+
+        std::fill(bins.begin(), bins.end(), Bin());
+        double scale = numBins / (boundsMax - boundsMin);
+        for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+        {
+            const BuildPrimitive &prim = prims[m_primIndices[i]];
+            int binIndex = std::min(numBins - 1, static_cast<int>((prim.centroid[a] - boundsMin) * scale));
+            bins[binIndex].count++;
+            bins[binIndex].bounds.expand(prim.bounds);
+        }
+
+        // Sweep from the left to gather the areas and counts of every left
+        // partition, then from the right to evaluate each plane.
+        AABB leftBox;
+        uint32_t leftSum = 0;
+        for (int i = 0; i < numBins - 1; i++)
+        {
+            leftSum += bins[i].count;
+            leftBox.expand(bins[i].bounds);
+            leftCount[i] = leftSum;
+            leftArea[i] = leftBox.surfaceArea();
+        }
+
+        AABB rightBox;
+        uint32_t rightSum = 0;
+        for (int i = numBins - 1; i > 0; i--)
+        {
+            rightSum += bins[i].count;
+            rightBox.expand(bins[i].bounds);
+            if (leftCount[i - 1] == 0 || rightSum == 0)
+                continue;
+
+            double cost = leftCount[i - 1] * leftArea[i - 1] + rightSum * rightBox.surfaceArea();
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                axis = a;
+                splitPos = boundsMin + i / scale;
+            }
+        }
+    }
+
+    if (axis < 0)
+        return math::INIFINITY;
+
+    double nodeArea = node.bounds.surfaceArea();
+    if (nodeArea <= 0.0)
+        return m_settings.traversalCost + m_settings.intersectionCost * node.count;
+
+    return m_settings.traversalCost + m_settings.intersectionCost * bestCost / nodeArea;
+}
+
+void BVH::subdivide(uint32_t nodeIndex, uint32_t depth, const std::vector<BuildPrimitive> &prims)
+{
+    Node &node = m_nodes[nodeIndex];
+    if (node.count <= 1 || depth >= MAX_DEPTH)
+        return;
+
+    int axis;
+    double splitPos;
+    double splitCost = findBestSplit(node, prims, axis, splitPos);
+    double leafCost = m_settings.intersectionCost * node.count;
+
+    if (splitCost >= leafCost && node.count <= static_cast<uint32_t>(m_settings.maxLeafSize))
+        return;
+
+    uint32_t first = node.leftFirst;
+    uint32_t last = node.leftFirst + node.count;
+    uint32_t mid = first;
+
+    if (axis >= 0)
+    {
+        auto it = std::partition(m_primIndices.begin() + first, m_primIndices.begin() + last,
+                                 [&](uint32_t i)
+                                 { return prims[i].centroid[axis] < splitPos; });
+        mid = static_cast<uint32_t>(it - m_primIndices.begin());
+    }
+
+    // Centroids that cannot be separated by a plane (or a plane that ends up
+    // on one side due to rounding) fall back to a median split so that
+    // oversized leaves still get divided.
+    if (mid == first || mid == last)
+    {
+        int medianAxis = axis >= 0 ? axis : node.bounds.largestAxis();
+        mid = first + node.count / 2;
+        std::nth_element(m_primIndices.begin() + first, m_primIndices.begin() + mid, m_primIndices.begin() + last,
+                         [&](uint32_t a, uint32_t b)
+                         { return prims[a].centroid[medianAxis] < prims[b].centroid[medianAxis]; });
+    }
+
+    uint32_t leftIndex = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+    m_nodes.emplace_back();
+
+    m_nodes[leftIndex].leftFirst = first;
+    m_nodes[leftIndex].count = mid - first;
+    m_nodes[leftIndex + 1].leftFirst = mid;
+    m_nodes[leftIndex + 1].count = last - mid;
+
+    m_nodes[nodeIndex].leftFirst = leftIndex;
+    m_nodes[nodeIndex].count = 0;
+
+    updateNodeBounds(leftIndex, prims);
+    updateNodeBounds(leftIndex + 1, prims);
+    subdivide(leftIndex, depth + 1, prims);
+    subdivide(leftIndex + 1, depth + 1, prims);
+}
+
+void BVH::computeStats(uint32_t primCount)
+{
+    m_stats.primitiveCount = primCount;
+    m_stats.referenceCount = static_cast<uint32_t>(m_primIndices.size());
+    m_stats.nodeCount = static_cast<uint32_t>(m_nodes.size());
+    if (m_nodes.empty())
+        return;
+
+    std::vector<std::pair<uint32_t, uint32_t>> stack{{0, 0}};
+    while (!stack.empty())
+    {
+        auto [nodeIndex, depth] = stack.back();
+        stack.pop_back();
+
+        const Node &node = m_nodes[nodeIndex];
+        m_stats.maxDepth = std::max(m_stats.maxDepth, depth);
+
+        if (node.isLeaf())
+        {
+            m_stats.leafCount++;
+            m_stats.maxLeafPrimitives = std::max(m_stats.maxLeafPrimitives, node.count);
+        }
+        else
+        {
+            stack.push_back({node.leftFirst, depth + 1});
+            stack.push_back({node.leftFirst + 1, depth + 1});
+        }
+    }
+
+    m_stats.sahCost = computeSAHCost();
+    m_builtSahCost = m_stats.sahCost;
+}
+
+// SAH cost of the whole tree, normalized by the root surface area.
+double BVH::computeSAHCost() const
+{
+    double rootArea = m_nodes[0].bounds.surfaceArea();
+    if (rootArea <= 0.0)
+        return 0.0;
+
+    double sahCost = 0.0;
+    for (const Node &node : m_nodes)
+    {
+        double area = node.bounds.surfaceArea() / rootArea;
+        sahCost += node.isLeaf() ? m_settings.intersectionCost * area * node.count
+                                 : m_settings.traversalCost * area;
+    }
+    return sahCost;
+}
+
+namespace raytracer
+{
+    std::ostream &operator<<(std::ostream &out, const BVHStats &stats)
+    {
+        out << "BVH" << stats.width << ": " << stats.primitiveCount << " primitives, ";
+        if (stats.referenceCount != stats.primitiveCount)
+            out << stats.referenceCount << " references, ";
+        out << stats.nodeCount << " nodes, "
+            << stats.leafCount << " leaves, "
+            << "max depth " << stats.maxDepth << ", "
+            << "max leaf size " << stats.maxLeafPrimitives << ", "
+            << "SAH cost " << stats.sahCost << ", "
+            << "built in " << stats.buildTimeMs << "ms ("
+            << stats.buildTimeMs * 1e6 / std::max(1u, stats.primitiveCount) << "ms per million primitives)";
+        if (stats.refitCount > 0)
+            out << ", " << stats.refitCount << " refits (last " << stats.refitTimeMs << "ms)";
+        return out;
+    }
+
+    std::ostream &operator<<(std::ostream &out, const TraversalStats &stats)
+    {
+        double rays = stats.rays > 0 ? static_cast<double>(stats.rays) : 1.0;
+        return out << "Traversal: " << stats.rays << " rays, "
+                   << stats.nodesVisited / rays << " nodes/ray, "
+                   << stats.primitivesTested / rays << " primitives/ray";
+    }
+}
@@ -0,0 +1,330 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "aabb.h"
+#include "../utils/hitinfo.h"
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+namespace raytracer
+{
+    // Node layout used for traversal. Wide layouts are collapsed from the
+    // binary hierarchy and test all children of a node with SIMD.
+    enum class BVHLayout
+    {
+        BINARY,
+        WIDE4,
+        WIDE8
+    };
+
+    // Algorithm used to build the binary hierarchy.
+    enum class BVHBuilder
+    {
+        // Binned surface area heuristic. Best traversal quality.
+        SAH,
+        // Linear BVH from sorted Morton codes, built in parallel. Much faster
+        // to build, at the cost of traversal quality.
+        LBVH,
+        // SAH with spatial splits (Stich et al., "Spatial Splits in Bounding
+        // Volume Hierarchies", 2009). Primitives straddling a split plane may
+        // be referenced from both sides, which tightens nodes around long or
+        // large primitives. Slowest to build, best traversal quality. Needs a
+        // PrimitiveSplitFunc, and behaves like SAH without one.
+        SBVH
+    };
+
+    /**
+     * Splits the part of primitive primIndex inside bounds at the plane
+     * axis = position, and returns the bounds of the parts on either side
+     * (empty when there is none). Used by the SBVH builder.
+     */
+    using PrimitiveSplitFunc = std::function<void(uint32_t primIndex, const AABB &bounds, int axis, double position, AABB &left, AABB &right)>;
+
+    struct BVHSettings
+    {
+        BVHBuilder builder = BVHBuilder::SAH;
+        BVHLayout layout = BVHLayout::BINARY;
+        // Worker threads used by parallel builders.
+        int numThreads = 1;
+        // Nodes with at most this many primitives may become leaves. Nodes
+        // holding more are always split. LBVH leaves hold one primitive.
+        int maxLeafSize = 4;
+        // Number of bins per axis used to evaluate SAH split candidates.
+        int numBins = 16;
+        // Relative SAH costs of visiting a node and intersecting a primitive.
+        double traversalCost = 1.0;
+        double intersectionCost = 1.0;
+        // When refitting raises the SAH cost above this multiple of the cost
+        // right after the last build, owners should rebuild instead.
+        double rebuildThreshold = 1.3;
+        // SBVH only. Spatial splits are tried when the children of the best
+        // object split overlap by more than this fraction of the root
+        // surface area.
+        double spatialSplitAlpha = 1e-5;
+        // SBVH only. Maximum number of extra primitive references created by
+        // spatial splits, as a fraction of the primitive count.
+        double spatialSplitBudget = 0.3;
+    };
+
+    struct BVHStats
+    {
+        // Maximum number of children per node.
+        uint32_t width = 2;
+        uint32_t primitiveCount = 0;
+        // References to primitives from leaves. Larger than primitiveCount
+        // when spatial splits duplicated primitives.
+        uint32_t referenceCount = 0;
+        uint32_t nodeCount = 0;
+        uint32_t leafCount = 0;
+        uint32_t maxDepth = 0;
+        uint32_t maxLeafPrimitives = 0;
+        double sahCost = 0.0;
+        double buildTimeMs = 0.0;
+        // Refits since the last build.
+        uint32_t refitCount = 0;
+        double refitTimeMs = 0.0;
+
+        friend std::ostream &operator<<(std::ostream &out, const BVHStats &stats);
+    };
+
+    // Counters filled in by a traversal when requested.
+    struct TraversalStats
+    {
+        uint64_t rays = 0;
+        uint64_t nodesVisited = 0;
+        uint64_t primitivesTested = 0;
+
+        friend std::ostream &operator<<(std::ostream &out, const TraversalStats &stats);
+    };
+
+    /**
+     * @brief Binary bounding volume hierarchy over an arbitrary set of
+     * primitives, built with binned surface area heuristic splits.
+     *
+     * The hierarchy only knows about primitive bounds. Intersection of the
+     * primitives themselves is delegated to the caller during traversal, so
+     * the same structure serves triangles in a Mesh as well as any other
+     * geometry.
+     */
+    class BVH
+    {
+    public:
+        // Deeper nodes are turned into leaves, which bounds the traversal
+        // stack size.
+        static constexpr uint32_t MAX_DEPTH = 64;
+
+        struct Node
+        {
+            AABB bounds;
+            // Index of the left child for interior nodes (the right child is
+            // always leftFirst + 1), or of the first primitive reference for
+            // leaves.
+            uint32_t leftFirst = 0;
+            // Number of primitives for leaves, 0 for interior nodes.
+            uint32_t count = 0;
+
+            inline bool isLeaf() const { return count > 0; }
+        };
+
+    private:
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_primIndices;
+        // Parent of every node, created on the first refit.
+        std::vector<uint32_t> m_parents;
+        BVHSettings m_settings;
+        BVHStats m_stats;
+        double m_builtSahCost = 0.0;
+
+        struct BuildPrimitive
+        {
+            AABB bounds;
+            Point centroid = Point::zero;
+        };
+
+        void updateNodeBounds(uint32_t nodeIndex, const std::vector<BuildPrimitive> &prims);
+        void subdivide(uint32_t nodeIndex, uint32_t depth, const std::vector<BuildPrimitive> &prims);
+        double findBestSplit(const Node &node, const std::vector<BuildPrimitive> &prims, int &axis, double &splitPos) const;
+        void computeStats(uint32_t primCount);
+        double computeSAHCost() const;
+
+        // Defined in lbvh.cpp
+        void buildLinear(const std::vector<AABB> &primBounds);
+
+        // Defined in sbvh.cpp
+        struct SpatialBuilder;
+        void buildSpatial(const std::vector<AABB> &primBounds, const PrimitiveSplitFunc &splitPrimitive);
+
+    public:
+        BVH() = default;
+
+        void build(const std::vector<AABB> &primBounds, const BVHSettings &settings = BVHSettings(),
+                   const PrimitiveSplitFunc &splitPrimitive = nullptr);
+
+        /**
+         * Recomputes node bounds bottom-up for primitives that moved, keeping
+         * the topology. primBounds must hold the same primitives, in the same
+         * order, as the last build. Leaves of an SBVH grow back to the full
+         * bounds of their primitives. Returns the SAH cost of the refitted tree
+         * relative to its cost right after the last build, so the caller can
+         * decide to rebuild (see BVHSettings::rebuildThreshold).
+         */
+        double refit(const std::vector<AABB> &primBounds);
+
+        inline bool isEmpty() const { return m_nodes.empty(); }
+        inline AABB getBounds() const { return isEmpty() ? AABB() : m_nodes[0].bounds; }
+        const BVHStats &getStats() const { return m_stats; }
+        const BVHSettings &getSettings() const { return m_settings; }
+        const std::vector<Node> &getNodes() const { return m_nodes; }
+        const std::vector<uint32_t> &getPrimIndices() const { return m_primIndices; }
+
+        /**
+         * Finds the closest primitive hit along the ray. hitPrimitive is
+         * called as hitPrimitive(primIndex, tMin, tMax, hitInfo) for every
+         * primitive in a visited leaf, and must only report hits closer than
+         * tMax. Children are visited near to far so that the closest hit
+         * found so far culls as much of the tree as possible.
+         */
+        template <typename HitFunc>
+        bool isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo,
+                   HitFunc hitPrimitive, TraversalStats *stats = nullptr) const
+        {
+            if (m_nodes.empty())
+                return false;
+
+            Vector3 invDir(1.0 / ray.direction[0], 1.0 / ray.direction[1], 1.0 / ray.direction[2]);
+            double closestHitDist = tMax;
+            bool isHit = false;
+            HitInfo tempHitInfo;
+
+            // Entry distances are kept alongside the node indices so that
+            // nodes behind a closer hit found later can be skipped.
+            uint32_t stack[MAX_DEPTH + 1];
+            double stackDist[MAX_DEPTH + 1];
+            uint32_t stackSize = 0;
+            double tEntry;
+
+            if (stats)
+                stats->rays++;
+
+            if (!m_nodes[0].bounds.isHit(ray, invDir, tMin, closestHitDist, tEntry))
+                return false;
+            stack[stackSize] = 0;
+            stackDist[stackSize++] = tEntry;
+
+            while (stackSize > 0)
+            {
+                stackSize--;
+                if (stackDist[stackSize] > closestHitDist)
+                    continue;
+                const Node &node = m_nodes[stack[stackSize]];
+                if (stats)
+                    stats->nodesVisited++;
+
+                if (node.isLeaf())
+                {
+                    for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+                    {
+                        if (stats)
+                            stats->primitivesTested++;
+                        if (hitPrimitive(m_primIndices[i], tMin, closestHitDist, tempHitInfo))
+                        {
+                            hitInfo = tempHitInfo;
+                            closestHitDist = tempHitInfo.distInRay;
+                            isHit = true;
+                        }
+                    }
+                    continue;
+                }
+
+                uint32_t near = node.leftFirst;
+                uint32_t far = node.leftFirst + 1;
+                double tNear = 0.0, tFar = 0.0;
+                bool isNearHit = m_nodes[near].bounds.isHit(ray, invDir, tMin, closestHitDist, tNear);
+                bool isFarHit = m_nodes[far].bounds.isHit(ray, invDir, tMin, closestHitDist, tFar);
+
+                if (isNearHit && isFarHit)
+                {
+                    if (tFar < tNear)
+                    {
+                        std::swap(near, far);
+                        std::swap(tNear, tFar);
+                    }
+                    stack[stackSize] = far;
+                    stackDist[stackSize++] = tFar;
+                    stack[stackSize] = near;
+                    stackDist[stackSize++] = tNear;
+                }
+                else if (isNearHit)
+                {
+                    stack[stackSize] = near;
+                    stackDist[stackSize++] = tNear;
+                }
+                else if (isFarHit)
+                {
+                    stack[stackSize] = far;
+                    stackDist[stackSize++] = tFar;
+                }
+            }
+
+            return isHit;
+        }
+
+        /**
+         * Any hit query. occludedPrimitive is called as
+         * occludedPrimitive(primIndex, tMin, tMax) and traversal stops at the
+         * first primitive for which it returns true. Children are not
+         * ordered, since the first hit found ends the query.
+         */
+        template <typename OccludedFunc>
+        bool isOccluded(const Ray &ray, double tMin, double tMax,
+                        OccludedFunc occludedPrimitive, TraversalStats *stats = nullptr) const
+        {
+            if (m_nodes.empty())
+                return false;
+
+            Vector3 invDir(1.0 / ray.direction[0], 1.0 / ray.direction[1], 1.0 / ray.direction[2]);
+            uint32_t stack[MAX_DEPTH + 1];
+            uint32_t stackSize = 0;
+            double tEntry;
+
+            if (stats)
+                stats->rays++;
+
+            if (!m_nodes[0].bounds.isHit(ray, invDir, tMin, tMax, tEntry))
+                return false;
+            stack[stackSize++] = 0;
+
+            while (stackSize > 0)
+            {
+                const Node &node = m_nodes[stack[--stackSize]];
+                if (stats)
+                    stats->nodesVisited++;
+
+                if (node.isLeaf())
+                {
+                    for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+                    {
+                        if (stats)
+                            stats->primitivesTested++;
+                        if (occludedPrimitive(m_primIndices[i], tMin, tMax))
+                            return true;
+                    }
+                    continue;
+                }
+
+                for (uint32_t child = node.leftFirst; child < node.leftFirst + 2; child++)
+                {
+                    if (m_nodes[child].bounds.isHit(ray, invDir, tMin, tMax, tEntry))
+                        stack[stackSize++] = child;
+                }
+            }
+
+            return false;
+        }
+    };
+}
+
+#endif
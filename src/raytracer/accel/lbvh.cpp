@@ -0,0 +1,252 @@
+#include "bvh.h"
+#include "../../utils/parallel.h"
+
+#include <atomic>
+#include <memory>
+
+using namespace raytracer;
+
+/**
+ * Linear BVH construction (Karras, "Maximizing Parallelism in the
+ * Construction of BVHs, Octrees, and k-d Trees", 2012):
+ *
+ *   1. Quantize primitive centroids to a 1024^3 grid and interleave the bits
+ *      into 30-bit Morton codes.
+ *   2. Sort primitives by Morton code with a parallel LSD radix sort.
+ *   3. Emit every interior node independently. Interior node i of the sorted
+ *      sequence finds the range of keys it covers and the position where
+ *      the highest differing bit changes, which is its split.
+ *   4. Refit bounds bottom-up in parallel. Every leaf walks towards the root,
+ *      and only the second thread to reach a node continues, once both of
+ *      its children are final.
+ */
+namespace
+{
+    // Spreads the lower 10 bits of x so that there are two zero bits between
+    // each of them.
+    inline uint32_t expandBits(uint32_t x)
+    {
+        x = (x * 0x00010001u) & 0xFF0000FFu;
+        x = (x * 0x00000101u) & 0x0F00F00Fu;
+        x = (x * 0x00000011u) & 0xC30C30C3u;
+        x = (x * 0x00000005u) & 0x49249249u;
+        return x;
+    }
+
+    inline uint32_t mortonCode(const Point &p, const AABB &bounds)
+    {
+        uint32_t code = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            double extent = bounds.max[i] - bounds.min[i];
+            double t = extent > 0.0 ? (p[i] - bounds.min[i]) / extent : 0.5;
+            uint32_t q = static_cast<uint32_t>(std::min(std::max(t * 1024.0, 0.0), 1023.0));
+            code |= expandBits(q) << (2 - i);
+        }
+        return code;
+    }
+
+    /**
+     * Stable LSD radix sort of 32-bit keys with 8-bit digits, carrying values
+     * along. Each pass histograms one chunk per thread, turns the histograms
+     * into per-thread scatter offsets, and scatters every chunk in order.
+     */
+    void radixSort(std::vector<uint32_t> &keys, std::vector<uint32_t> &values, int numThreads)
+    {
+        constexpr int RADIX = 256;
+        uint32_t count = static_cast<uint32_t>(keys.size());
+        numThreads = std::max(1, std::min(numThreads, static_cast<int>(count)));
+
+        std::vector<uint32_t> keysOut(count);
+        std::vector<uint32_t> valuesOut(count);
+        std::vector<uint32_t> histograms(static_cast<size_t>(numThreads) * RADIX);
+
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            std::fill(histograms.begin(), histograms.end(), 0);
+            parallelFor(numThreads, count, [&](uint32_t begin, uint32_t end, int thread)
+                        {
+                            uint32_t *hist = &histograms[static_cast<size_t>(thread) * RADIX];
+                            for (uint32_t i = begin; i < end; i++)
+                                hist[(keys[i] >> shift) & (RADIX - 1)]++; });
+
+            // Exclusive prefix sum in digit-major, thread-minor order keeps
+            // the sort stable.
+            uint32_t sum = 0;
+            for (int d = 0; d < RADIX; d++)
+            {
+                for (int t = 0; t < numThreads; t++)
+                {
+                    uint32_t &h = histograms[static_cast<size_t>(t) * RADIX + d];
+                    uint32_t c = h;
+                    h = sum;
+                    sum += c;
+                }
+            }
+
+            parallelFor(numThreads, count, [&](uint32_t begin, uint32_t end, int thread)
+                        {
+                            uint32_t *offsets = &histograms[static_cast<size_t>(thread) * RADIX];
+                            for (uint32_t i = begin; i < end; i++)
+                            {
+                                uint32_t dst = offsets[(keys[i] >> shift) & (RADIX - 1)]++;
+                                keysOut[dst] = keys[i];
+                                valuesOut[dst] = values[i];
+                            } });
+
+            keys.swap(keysOut);
+            values.swap(valuesOut);
+        }
+    }
+
+    // Length of the common prefix of the keys at sorted positions i and j, or
+    // -1 if j is out of range. Equal Morton codes are made unique by
+    // appending the sorted position.
+    inline int commonPrefix(const std::vector<uint32_t> &codes, int64_t i, int64_t j)
+    {
+        if (j < 0 || j >= static_cast<int64_t>(codes.size()))
+            return -1;
+        uint64_t a = (static_cast<uint64_t>(codes[i]) << 32) | static_cast<uint64_t>(i);
+        uint64_t b = (static_cast<uint64_t>(codes[j]) << 32) | static_cast<uint64_t>(j);
+        return __builtin_clzll(a ^ b);
+    }
+}
+
+void BVH::buildLinear(const std::vector<AABB> &primBounds)
+{
+    const int numThreads = m_settings.numThreads;
+    const uint32_t primCount = static_cast<uint32_t>(primBounds.size());
+
+    // 1. Morton codes of the centroids.
+    std::vector<Point> centroids(primCount, Point::zero);
+    AABB centroidBounds;
+    for (uint32_t i = 0; i < primCount; i++)
+    {
+        if (!primBounds[i].isEmpty())
+            centroids[i] = primBounds[i].centroid();
+        centroidBounds.expand(centroids[i]);
+    }
+
+    std::vector<uint32_t> codes(primCount);
+    m_primIndices.resize(primCount);
+    parallelFor(numThreads, primCount, [&](uint32_t begin, uint32_t end, int)
+                {
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        codes[i] = mortonCode(centroids[i], centroidBounds);
+                        m_primIndices[i] = i;
+                    } });
+
+    // 2. Sort primitive references by code.
+    radixSort(codes, m_primIndices, numThreads);
+
+    // A binary tree over N single primitive leaves has N - 1 interior nodes.
+    // Interior node i of the sorted sequence is the parent of the sibling
+    // pair stored at 2i + 1 and 2i + 2, and the root is stored at 0.
+    m_nodes.resize(2 * static_cast<size_t>(primCount) - 1);
+    if (primCount == 1)
+    {
+        m_nodes[0].bounds = primBounds[m_primIndices[0]];
+        m_nodes[0].leftFirst = 0;
+        m_nodes[0].count = 1;
+        return;
+    }
+
+    const uint32_t internalCount = primCount - 1;
+    std::vector<uint32_t> internalSlot(internalCount);
+    internalSlot[0] = 0;
+
+    // 3. Emit interior nodes. Every node writes where its interior children
+    // live and fills in its leaf children.
+    parallelFor(numThreads, internalCount, [&](uint32_t begin, uint32_t end, int)
+                {
+                    for (uint32_t n = begin; n < end; n++)
+                    {
+                        int64_t i = n;
+
+                        // Direction of the range covered by this node.
+                        int d = commonPrefix(codes, i, i + 1) - commonPrefix(codes, i, i - 1) > 0 ? 1 : -1;
+                        int minPrefix = commonPrefix(codes, i, i - d);
+
+                        // Upper bound for the range length, then binary search
+                        // for the other end.
+                        int64_t lMax = 2;
+                        while (commonPrefix(codes, i, i + lMax * d) > minPrefix)
+                            lMax *= 2;
+                        int64_t l = 0;
+                        for (int64_t t = lMax / 2; t >= 1; t /= 2)
+                            if (commonPrefix(codes, i, i + (l + t) * d) > minPrefix)
+                                l += t;
+                        int64_t j = i + l * d;
+
+                        // Binary search for the split position.
+                        int nodePrefix = commonPrefix(codes, i, j);
+                        int64_t s = 0;
+                        int64_t t = l;
+                        do
+                        {
+                            t = (t + 1) / 2;
+                            if (commonPrefix(codes, i, i + (s + t) * d) > nodePrefix)
+                                s += t;
+                        } while (t > 1);
+                        int64_t split = i + s * d + std::min(d, 0);
+
+                        int64_t first = std::min(i, j);
+                        int64_t last = std::max(i, j);
+                        uint32_t slots[2] = {2 * n + 1, 2 * n + 2};
+                        int64_t children[2] = {split, split + 1};
+                        bool isLeaf[2] = {first == split, last == split + 1};
+
+                        for (int c = 0; c < 2; c++)
+                        {
+                            if (isLeaf[c])
+                            {
+                                Node &leaf = m_nodes[slots[c]];
+                                leaf.bounds = primBounds[m_primIndices[children[c]]];
+                                leaf.leftFirst = static_cast<uint32_t>(children[c]);
+                                leaf.count = 1;
+                            }
+                            else
+                                internalSlot[children[c]] = slots[c];
+                        }
+                    } });
+
+    parallelFor(numThreads, internalCount, [&](uint32_t begin, uint32_t end, int)
+                {
+                    for (uint32_t n = begin; n < end; n++)
+                    {
+                        Node &node = m_nodes[internalSlot[n]];
+                        node.leftFirst = 2 * n + 1;
+                        node.count = 0;
+                    } });
+
+    // 4. Refit. Slot s > 0 belongs to interior node (s - 1) / 2.
+    std::unique_ptr<std::atomic<uint32_t>[]> visits(new std::atomic<uint32_t>[internalCount]);
+    for (uint32_t n = 0; n < internalCount; n++)
+        visits[n].store(0, std::memory_order_relaxed);
+
+    const uint32_t nodeCount = static_cast<uint32_t>(m_nodes.size());
+    parallelFor(numThreads, nodeCount - 1, [&](uint32_t begin, uint32_t end, int)
+                {
+                    for (uint32_t slot = begin + 1; slot < end + 1; slot++)
+                    {
+                        if (!m_nodes[slot].isLeaf())
+                            continue;
+
+                        uint32_t s = slot;
+                        while (s != 0)
+                        {
+                            uint32_t parent = (s - 1) / 2;
+                            // The first child to arrive stops. The second one
+                            // sees the sibling's final bounds.
+                            if (visits[parent].fetch_add(1, std::memory_order_acq_rel) == 0)
+                                break;
+
+                            Node &node = m_nodes[internalSlot[parent]];
+                            AABB bounds = m_nodes[node.leftFirst].bounds;
+                            bounds.expand(m_nodes[node.leftFirst + 1].bounds);
+                            node.bounds = bounds;
+                            s = internalSlot[parent];
+                        }
+                    } });
+}
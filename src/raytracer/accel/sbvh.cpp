@@ -0,0 +1,440 @@
+#include "bvh.h"
+
+#include <algorithm>
+
+using namespace raytracer;
+
+/**
+ * Spatial split BVH construction (Stich et al., "Spatial Splits in Bounding
+ * Volume Hierarchies", 2009).
+ *
+ * The builder works on references: a primitive together with the part of its
+ * bounds that a node covers. Every node evaluates the best binned object
+ * split, like the SAH builder, and, when the children of that split overlap,
+ * also the best spatial split. A spatial split bins the references by their
+ * extent instead of their centroid, chopping straddling references at every
+ * bin boundary, so the children of a plane never overlap. References that
+ * straddle the chosen plane are either split in two or, when that is cheaper,
+ * kept whole on one side ("unsplitting"). Splitting stops once the
+ * duplication budget is used up.
+ */
+struct BVH::SpatialBuilder
+{
+    struct Reference
+    {
+        AABB bounds;
+        uint32_t primIndex = 0;
+    };
+
+    struct ObjectSplit
+    {
+        double cost = math::INIFINITY;
+        int axis = -1;
+        // References in bins below this one go left.
+        int bin = 0;
+        AABB leftBounds;
+        AABB rightBounds;
+    };
+
+    struct SpatialSplit
+    {
+        double cost = math::INIFINITY;
+        int axis = -1;
+        double position = 0.0;
+    };
+
+    BVH &bvh;
+    const BVHSettings &settings;
+    const PrimitiveSplitFunc &splitPrimitive;
+    // Overlap area of object split children above which spatial splits are
+    // evaluated.
+    double minOverlapArea;
+    uint32_t remainingDuplicates;
+
+    SpatialBuilder(BVH &bvh, const PrimitiveSplitFunc &splitPrimitive, double rootArea, uint32_t primCount)
+        : bvh{bvh},
+          settings{bvh.m_settings},
+          splitPrimitive{splitPrimitive},
+          minOverlapArea{settings.spatialSplitAlpha * rootArea},
+          remainingDuplicates{static_cast<uint32_t>(settings.spatialSplitBudget * primCount)} {}
+
+    static inline Point centroid(const AABB &bounds)
+    {
+        return bounds.isEmpty() ? Point::zero : bounds.centroid();
+    }
+
+    static inline int binIndex(double value, double boundsMin, double scale, int numBins)
+    {
+        return std::min(numBins - 1, std::max(0, static_cast<int>((value - boundsMin) * scale)));
+    }
+
+    void splitReference(const Reference &ref, int axis, double position, Reference &left, Reference &right) const
+    {
+        left.primIndex = right.primIndex = ref.primIndex;
+        splitPrimitive(ref.primIndex, ref.bounds, axis, position, left.bounds, right.bounds);
+
+        // Boxes that are empty along one axis would still grow the others
+        // when merged, so they are reset to the canonical empty box.
+        if (left.bounds.isEmpty())
+            left.bounds = AABB();
+        if (right.bounds.isEmpty())
+            right.bounds = AABB();
+    }
+
+    ObjectSplit findObjectSplit(const std::vector<Reference> &refs) const
+    {
+        struct Bin
+        {
+            AABB bounds;
+            uint32_t count = 0;
+        };
+
+        const int numBins = settings.numBins;
+        std::vector<Bin> bins(numBins);
+        std::vector<AABB> leftBounds(numBins - 1);
+        std::vector<uint32_t> leftCount(numBins - 1);
+
+        AABB centroidBounds;
+        for (const Reference &ref : refs)
+            centroidBounds.expand(centroid(ref.bounds));
+
+        ObjectSplit best;
+        for (int a = 0; a < 3; a++)
+        {
+            double boundsMin = centroidBounds.min[a];
+            double boundsMax = centroidBounds.max[a];
+            if (boundsMax <= boundsMin)
+                continue;
+
+            std::fill(bins.begin(), bins.end(), Bin());
+            double scale = numBins / (boundsMax - boundsMin);
+            for (const Reference &ref : refs)
+            {
+                Bin &bin = bins[binIndex(centroid(ref.bounds)[a], boundsMin, scale, numBins)];
+                bin.count++;
+                bin.bounds.expand(ref.bounds);
+            }
+
+            AABB leftBox;
+            uint32_t leftSum = 0;
+            for (int i = 0; i < numBins - 1; i++)
+            {
+                leftSum += bins[i].count;
+                leftBox.expand(bins[i].bounds);
+                leftCount[i] = leftSum;
+                leftBounds[i] = leftBox;
+            }
+
+            AABB rightBox;
+            uint32_t rightSum = 0;
+            for (int i = numBins - 1; i > 0; i--)
+            {
+                rightSum += bins[i].count;
+                rightBox.expand(bins[i].bounds);
+                if (leftCount[i - 1] == 0 || rightSum == 0)
+                    continue;
+
+                double cost = leftCount[i - 1] * leftBounds[i - 1].surfaceArea() + rightSum * rightBox.surfaceArea();
+                if (cost < best.cost)
+                {
+                    best.cost = cost;
+                    best.axis = a;
+                    best.bin = i;
+                    best.leftBounds = leftBounds[i - 1];
+                    best.rightBounds = rightBox;
+                }
+            }
+        }
+
+        return best;
+    }
+
+    SpatialSplit findSpatialSplit(const std::vector<Reference> &refs, const AABB &nodeBounds) const
+    {
+        struct Bin
+        {
+            AABB bounds;
+            // References starting and ending in this bin.
+            uint32_t entries = 0;
+            uint32_t exits = 0;
+        };
+
+        const int numBins = settings.numBins;
+        std::vector<Bin> bins(numBins);
+        std::vector<double> leftArea(numBins - 1);
+        std::vector<uint32_t> leftCount(numBins - 1);
+
+        SpatialSplit best;
+        for (int a = 0; a < 3; a++)
+        {
+            double boundsMin = nodeBounds.min[a];
+            double boundsMax = nodeBounds.max[a];
+            if (boundsMax <= boundsMin)
+                continue;
+
+            std::fill(bins.begin(), bins.end(), Bin());
+            double scale = numBins / (boundsMax - boundsMin);
+            for (const Reference &ref : refs)
+            {
+                if (ref.bounds.isEmpty())
+                {
+                    bins[0].entries++;
+                    bins[0].exits++;
+                    continue;
+                }
+
+                int first = binIndex(ref.bounds.min[a], boundsMin, scale, numBins);
+                int last = std::max(first, binIndex(ref.bounds.max[a], boundsMin, scale, numBins));
+
+                // Chop the reference at every bin boundary it crosses.
+                Reference rest = ref;
+                for (int i = first; i < last; i++)
+                {
+                    Reference left, right;
+                    splitReference(rest, a, boundsMin + (i + 1) / scale, left, right);
+                    bins[i].bounds.expand(left.bounds);
+                    rest = right;
+                }
+                bins[last].bounds.expand(rest.bounds);
+                bins[first].entries++;
+                bins[last].exits++;
+            }
+
+            AABB leftBox;
+            uint32_t leftSum = 0;
+            for (int i = 0; i < numBins - 1; i++)
+            {
+                leftSum += bins[i].entries;
+                leftBox.expand(bins[i].bounds);
+                leftCount[i] = leftSum;
+                leftArea[i] = leftBox.surfaceArea();
+            }
+
+            AABB rightBox;
+            uint32_t rightSum = 0;
+            for (int i = numBins - 1; i > 0; i--)
+            {
+                rightSum += bins[i].exits;
+                rightBox.expand(bins[i].bounds);
+                if (leftCount[i - 1] == 0 || rightSum == 0)
+                    continue;
+
+                double cost = leftCount[i - 1] * leftArea[i - 1] + rightSum * rightBox.surfaceArea();
+                if (cost < best.cost)
+                {
+                    best.cost = cost;
+                    best.axis = a;
+                    best.position = boundsMin + i / scale;
+                }
+            }
+        }
+
+        return best;
+    }
+
+    void partitionObject(std::vector<Reference> &refs, const ObjectSplit &split,
+                         std::vector<Reference> &left, std::vector<Reference> &right) const
+    {
+        if (split.axis >= 0)
+        {
+            AABB centroidBounds;
+            for (const Reference &ref : refs)
+                centroidBounds.expand(centroid(ref.bounds));
+
+            const int numBins = settings.numBins;
+            double boundsMin = centroidBounds.min[split.axis];
+            double scale = numBins / (centroidBounds.max[split.axis] - boundsMin);
+            for (const Reference &ref : refs)
+            {
+                if (binIndex(centroid(ref.bounds)[split.axis], boundsMin, scale, numBins) < split.bin)
+                    left.push_back(ref);
+                else
+                    right.push_back(ref);
+            }
+        }
+
+        // Same median fallback as the SAH builder.
+        if (left.empty() || right.empty())
+        {
+            AABB bounds;
+            for (const Reference &ref : refs)
+                bounds.expand(ref.bounds);
+            int medianAxis = split.axis >= 0 ? split.axis : bounds.largestAxis();
+
+            size_t mid = refs.size() / 2;
+            std::nth_element(refs.begin(), refs.begin() + mid, refs.end(),
+                             [&](const Reference &a, const Reference &b)
+                             { return centroid(a.bounds)[medianAxis] < centroid(b.bounds)[medianAxis]; });
+            left.assign(refs.begin(), refs.begin() + mid);
+            right.assign(refs.begin() + mid, refs.end());
+        }
+    }
+
+    // Returns false when every reference ended up on one side.
+    bool partitionSpatial(const std::vector<Reference> &refs, const SpatialSplit &split,
+                          std::vector<Reference> &left, std::vector<Reference> &right)
+    {
+        const int axis = split.axis;
+        AABB leftBounds, rightBounds;
+        std::vector<const Reference *> straddling;
+
+        for (const Reference &ref : refs)
+        {
+            if (ref.bounds.isEmpty() || ref.bounds.max[axis] <= split.position)
+            {
+                left.push_back(ref);
+                leftBounds.expand(ref.bounds);
+            }
+            else if (ref.bounds.min[axis] >= split.position)
+            {
+                right.push_back(ref);
+                rightBounds.expand(ref.bounds);
+            }
+            else
+                straddling.push_back(&ref);
+        }
+
+        for (const Reference *ref : straddling)
+        {
+            Reference leftPart, rightPart;
+            splitReference(*ref, axis, split.position, leftPart, rightPart);
+
+            double leftCount = static_cast<double>(left.size());
+            double rightCount = static_cast<double>(right.size());
+
+            AABB leftWhole = leftBounds;
+            leftWhole.expand(ref->bounds);
+            AABB rightWhole = rightBounds;
+            rightWhole.expand(ref->bounds);
+
+            double keepLeftCost = leftWhole.surfaceArea() * (leftCount + 1) + rightBounds.surfaceArea() * rightCount;
+            double keepRightCost = leftBounds.surfaceArea() * leftCount + rightWhole.surfaceArea() * (rightCount + 1);
+
+            double splitCost = math::INIFINITY;
+            if (remainingDuplicates > 0 && !leftPart.bounds.isEmpty() && !rightPart.bounds.isEmpty())
+            {
+                AABB leftSplit = leftBounds;
+                leftSplit.expand(leftPart.bounds);
+                AABB rightSplit = rightBounds;
+                rightSplit.expand(rightPart.bounds);
+                splitCost = leftSplit.surfaceArea() * (leftCount + 1) + rightSplit.surfaceArea() * (rightCount + 1);
+            }
+
+            if (splitCost < keepLeftCost && splitCost < keepRightCost)
+            {
+                left.push_back(leftPart);
+                leftBounds.expand(leftPart.bounds);
+                right.push_back(rightPart);
+                rightBounds.expand(rightPart.bounds);
+                remainingDuplicates--;
+            }
+            else if (keepLeftCost <= keepRightCost)
+            {
+                left.push_back(*ref);
+                leftBounds = leftWhole;
+            }
+            else
+            {
+                right.push_back(*ref);
+                rightBounds = rightWhole;
+            }
+        }
+
+        return !left.empty() && !right.empty();
+    }
+
+    void makeLeaf(uint32_t nodeIndex, const std::vector<Reference> &refs)
+    {
+        Node &node = bvh.m_nodes[nodeIndex];
+        node.leftFirst = static_cast<uint32_t>(bvh.m_primIndices.size());
+        node.count = static_cast<uint32_t>(refs.size());
+        for (const Reference &ref : refs)
+            bvh.m_primIndices.push_back(ref.primIndex);
+    }
+
+    void subdivide(uint32_t nodeIndex, std::vector<Reference> &refs, uint32_t depth)
+    {
+        AABB nodeBounds;
+        for (const Reference &ref : refs)
+            nodeBounds.expand(ref.bounds);
+        bvh.m_nodes[nodeIndex].bounds = nodeBounds;
+
+        const uint32_t count = static_cast<uint32_t>(refs.size());
+        if (count <= 1 || depth >= MAX_DEPTH)
+        {
+            makeLeaf(nodeIndex, refs);
+            return;
+        }
+
+        ObjectSplit objectSplit = findObjectSplit(refs);
+
+        SpatialSplit spatialSplit;
+        if (remainingDuplicates > 0)
+        {
+            AABB overlap = objectSplit.leftBounds;
+            overlap.clip(objectSplit.rightBounds);
+            if (objectSplit.axis < 0 || overlap.surfaceArea() > minOverlapArea)
+                spatialSplit = findSpatialSplit(refs, nodeBounds);
+        }
+
+        double bestCost = std::min(objectSplit.cost, spatialSplit.cost);
+        double nodeArea = nodeBounds.surfaceArea();
+        double splitCost = nodeArea > 0.0 && bestCost < math::INIFINITY
+                               ? settings.traversalCost + settings.intersectionCost * bestCost / nodeArea
+                               : settings.traversalCost + settings.intersectionCost * count;
+        double leafCost = settings.intersectionCost * count;
+
+        if (splitCost >= leafCost && count <= static_cast<uint32_t>(settings.maxLeafSize))
+        {
+            makeLeaf(nodeIndex, refs);
+            return;
+        }
+
+        std::vector<Reference> left, right;
+        bool isSpatial = spatialSplit.cost < objectSplit.cost &&
+                         partitionSpatial(refs, spatialSplit, left, right);
+        if (!isSpatial)
+        {
+            left.clear();
+            right.clear();
+            partitionObject(refs, objectSplit, left, right);
+        }
+
+        // Only the children's references are needed from here on.
+        std::vector<Reference>().swap(refs);
+
+        uint32_t leftIndex = static_cast<uint32_t>(bvh.m_nodes.size());
+        bvh.m_nodes.emplace_back();
+        bvh.m_nodes.emplace_back();
+        bvh.m_nodes[nodeIndex].leftFirst = leftIndex;
+        bvh.m_nodes[nodeIndex].count = 0;
+
+        subdivide(leftIndex, left, depth + 1);
+        subdivide(leftIndex + 1, right, depth + 1);
+    }
+};
+
+void BVH::buildSpatial(const std::vector<AABB> &primBounds, const PrimitiveSplitFunc &splitPrimitive)
+{
+    const uint32_t primCount = static_cast<uint32_t>(primBounds.size());
+
+    std::vector<SpatialBuilder::Reference> refs(primCount);
+    AABB rootBounds;
+    for (uint32_t i = 0; i < primCount; i++)
+    {
+        refs[i].bounds = primBounds[i].isEmpty() ? AABB() : primBounds[i];
+        refs[i].primIndex = i;
+        rootBounds.expand(refs[i].bounds);
+    }
+
+    SpatialBuilder builder(*this, splitPrimitive, rootBounds.surfaceArea(), primCount);
+
+    size_t maxReferences = primCount + static_cast<size_t>(builder.remainingDuplicates);
+    m_primIndices.reserve(maxReferences);
+    m_nodes.reserve(2 * maxReferences);
+    m_nodes.emplace_back();
+    builder.subdivide(0, refs, 0);
+
+    m_nodes.shrink_to_fit();
+    m_primIndices.shrink_to_fit();
+}
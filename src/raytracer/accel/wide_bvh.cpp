@@ -0,0 +1,191 @@
+#include "wide_bvh.h"
+#include "../../utils/parallel.h"
+
+#include <chrono>
+#include <cmath>
+
+using namespace raytracer;
+
+namespace
+{
+    // Float conversions that never move a bound inwards.
+    inline float roundDown(double x)
+    {
+        float f = static_cast<float>(x);
+        return static_cast<double>(f) > x ? std::nextafter(f, -INFINITY) : f;
+    }
+
+    inline float roundUp(double x)
+    {
+        float f = static_cast<float>(x);
+        return static_cast<double>(f) < x ? std::nextafter(f, INFINITY) : f;
+    }
+}
+
+template <int N>
+void WideBVH<N>::build(const BVH &bvh)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    m_nodes.clear();
+    m_sources.clear();
+    m_primIndices = bvh.getPrimIndices();
+    m_stats = BVHStats();
+
+    if (bvh.isEmpty())
+        return;
+
+    m_nodes.reserve(bvh.getNodes().size() / (N - 1) + 1);
+
+    const BVH::Node &root = bvh.getNodes()[0];
+    if (root.isLeaf())
+    {
+        // A single leaf still needs a node to hold its bounds.
+        m_nodes.emplace_back();
+        m_sources.assign(N, INVALID_CHILD);
+        for (int c = 0; c < N; c++)
+            setChild(m_nodes[0], c, AABB(), INVALID_CHILD, 0);
+        setChild(m_nodes[0], 0, root.bounds, root.leftFirst, root.count);
+        m_sources[0] = 0;
+        m_stats.leafCount = 1;
+        m_stats.maxLeafPrimitives = root.count;
+    }
+    else
+        collapse(bvh, 0, 0);
+
+    m_nodes.shrink_to_fit();
+    m_sources.shrink_to_fit();
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    const BVHStats &binaryStats = bvh.getStats();
+    m_stats.width = N;
+    m_stats.primitiveCount = binaryStats.primitiveCount;
+    m_stats.referenceCount = binaryStats.referenceCount;
+    m_stats.nodeCount = static_cast<uint32_t>(m_nodes.size());
+    m_stats.sahCost = binaryStats.sahCost;
+    m_stats.buildTimeMs = binaryStats.buildTimeMs + elapsed.count();
+}
+
+template <int N>
+void WideBVH<N>::refit(const BVH &bvh, int numThreads)
+{
+    const std::vector<BVH::Node> &binaryNodes = bvh.getNodes();
+    parallelFor(numThreads, static_cast<uint32_t>(m_nodes.size()), [&](uint32_t begin, uint32_t end, int)
+                {
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        for (int c = 0; c < N; c++)
+                        {
+                            uint32_t source = m_sources[static_cast<size_t>(i) * N + c];
+                            if (source != INVALID_CHILD)
+                                setChildBounds(m_nodes[i], c, binaryNodes[source].bounds);
+                        }
+                    } });
+
+    const BVHStats &binaryStats = bvh.getStats();
+    m_stats.sahCost = binaryStats.sahCost;
+    m_stats.refitCount = binaryStats.refitCount;
+    m_stats.refitTimeMs = binaryStats.refitTimeMs;
+}
+
+template <int N>
+void WideBVH<N>::setChildBounds(Node &node, int slot, const AABB &bounds)
+{
+    node.minX[slot] = roundDown(bounds.min[0]);
+    node.minY[slot] = roundDown(bounds.min[1]);
+    node.minZ[slot] = roundDown(bounds.min[2]);
+    node.maxX[slot] = roundUp(bounds.max[0]);
+    node.maxY[slot] = roundUp(bounds.max[1]);
+    node.maxZ[slot] = roundUp(bounds.max[2]);
+}
+
+template <int N>
+void WideBVH<N>::setChild(Node &node, int slot, const AABB &bounds, uint32_t child, uint32_t count)
+{
+    if (child == INVALID_CHILD)
+    {
+        // Unused slots get an empty box. Traversal also skips them by
+        // child index, since an inverted box can still pass the slab test
+        // for rays with negative direction components.
+        node.minX[slot] = node.minY[slot] = node.minZ[slot] = INFINITY;
+        node.maxX[slot] = node.maxY[slot] = node.maxZ[slot] = -INFINITY;
+    }
+    else
+        setChildBounds(node, slot, bounds);
+    node.child[slot] = child;
+    node.count[slot] = count;
+}
+
+/**
+ * Pulls up to N descendants of a binary node into one wide node by
+ * repeatedly opening the interior child with the largest surface area, which
+ * is the child most likely to be visited by a ray.
+ */
+template <int N>
+uint32_t WideBVH<N>::collapse(const BVH &bvh, uint32_t binaryIndex, uint32_t depth)
+{
+    const std::vector<BVH::Node> &binaryNodes = bvh.getNodes();
+    const BVH::Node &binaryNode = binaryNodes[binaryIndex];
+
+    uint32_t children[N];
+    int childCount = 2;
+    children[0] = binaryNode.leftFirst;
+    children[1] = binaryNode.leftFirst + 1;
+
+    while (childCount < N)
+    {
+        int largest = -1;
+        double largestArea = -1.0;
+        for (int c = 0; c < childCount; c++)
+        {
+            const BVH::Node &child = binaryNodes[children[c]];
+            if (!child.isLeaf() && child.bounds.surfaceArea() > largestArea)
+            {
+                largest = c;
+                largestArea = child.bounds.surfaceArea();
+            }
+        }
+        if (largest < 0)
+            break;
+
+        uint32_t opened = children[largest];
+        children[largest] = binaryNodes[opened].leftFirst;
+        children[childCount++] = binaryNodes[opened].leftFirst + 1;
+    }
+
+    uint32_t nodeIndex = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+    m_sources.resize(m_sources.size() + N, INVALID_CHILD);
+    m_stats.maxDepth = std::max(m_stats.maxDepth, depth);
+
+    for (int c = 0; c < N; c++)
+    {
+        if (c >= childCount)
+        {
+            setChild(m_nodes[nodeIndex], c, AABB(), INVALID_CHILD, 0);
+            continue;
+        }
+
+        const BVH::Node &child = binaryNodes[children[c]];
+        m_sources[static_cast<size_t>(nodeIndex) * N + c] = children[c];
+        if (child.isLeaf())
+        {
+            setChild(m_nodes[nodeIndex], c, child.bounds, child.leftFirst, child.count);
+            m_stats.leafCount++;
+            m_stats.maxLeafPrimitives = std::max(m_stats.maxLeafPrimitives, child.count);
+        }
+        else
+        {
+            // Recursion may reallocate m_nodes, so the node is re-indexed
+            // after the call.
+            uint32_t childIndex = collapse(bvh, children[c], depth + 1);
+            setChild(m_nodes[nodeIndex], c, child.bounds, childIndex, 0);
+        }
+    }
+
+    return nodeIndex;
+}
+
+template class raytracer::WideBVH<4>;
+template class raytracer::WideBVH<8>;
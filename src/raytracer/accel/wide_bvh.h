@@ -0,0 +1,311 @@
+#ifndef WIDE_BVH_H
+#define WIDE_BVH_H
+
+#include "bvh.h"
+
+#include <cfloat>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define WIDE_BVH_SSE 1
+#endif
+
+#if defined(__AVX__)
+#define WIDE_BVH_AVX 1
+#endif
+
+namespace raytracer
+{
+    /**
+     * @brief BVH with N (4 or 8) children per node, collapsed from a binary
+     * BVH. Child bounds are stored as single precision structure of arrays so
+     * that a ray is tested against all children of a node at once: one SSE
+     * pass for 4 children, one AVX pass for 8 (two SSE passes when AVX is not
+     * enabled at compile time).
+     *
+     * Bounds are rounded outwards when converted to float, so a box never
+     * shrinks below the double precision box it was built from.
+     */
+    template <int N>
+    class WideBVH
+    {
+        static_assert(N == 4 || N == 8, "WideBVH supports 4 or 8 children per node");
+
+    public:
+        static constexpr uint32_t INVALID_CHILD = 0xffffffff;
+
+        struct alignas(32) Node
+        {
+            float minX[N], minY[N], minZ[N];
+            float maxX[N], maxY[N], maxZ[N];
+            // Node index for interior children, first primitive reference
+            // for leaf children, INVALID_CHILD for unused slots.
+            uint32_t child[N];
+            // Primitive count for leaf children, 0 otherwise.
+            uint32_t count[N];
+        };
+
+    private:
+        struct RayData
+        {
+            float origin[3];
+            float invDir[3];
+        };
+
+        struct StackEntry
+        {
+            uint32_t child;
+            uint32_t count;
+            float dist;
+        };
+
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_primIndices;
+        // Binary node each child slot was collapsed from (N per node), so
+        // that bounds can be refitted from the binary hierarchy.
+        std::vector<uint32_t> m_sources;
+        BVHStats m_stats;
+
+        uint32_t collapse(const BVH &bvh, uint32_t binaryIndex, uint32_t depth);
+        void setChild(Node &node, int slot, const AABB &bounds, uint32_t child, uint32_t count);
+        void setChildBounds(Node &node, int slot, const AABB &bounds);
+
+        // Tests the ray against children [offset, offset + 4) of the node.
+        // Returns a bit mask of the children hit and writes their entry
+        // distances.
+        static inline uint32_t intersect4(const Node &node, int offset, const RayData &ray, float tMin, float tMax, float *tEntry)
+        {
+#if WIDE_BVH_SSE
+            const __m128 ox = _mm_set1_ps(ray.origin[0]);
+            const __m128 oy = _mm_set1_ps(ray.origin[1]);
+            const __m128 oz = _mm_set1_ps(ray.origin[2]);
+            const __m128 ix = _mm_set1_ps(ray.invDir[0]);
+            const __m128 iy = _mm_set1_ps(ray.invDir[1]);
+            const __m128 iz = _mm_set1_ps(ray.invDir[2]);
+
+            __m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX + offset), ox), ix);
+            __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX + offset), ox), ix);
+            __m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY + offset), oy), iy);
+            __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY + offset), oy), iy);
+            __m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ + offset), oz), iz);
+            __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ + offset), oz), iz);
+
+            __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)),
+                                      _mm_max_ps(_mm_min_ps(t0z, t1z), _mm_set1_ps(tMin)));
+            __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)),
+                                     _mm_min_ps(_mm_max_ps(t0z, t1z), _mm_set1_ps(tMax)));
+
+            _mm_storeu_ps(tEntry, tNear);
+            return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)));
+#else
+            uint32_t mask = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                int c = offset + i;
+                float t0x = (node.minX[c] - ray.origin[0]) * ray.invDir[0];
+                float t1x = (node.maxX[c] - ray.origin[0]) * ray.invDir[0];
+                float t0y = (node.minY[c] - ray.origin[1]) * ray.invDir[1];
+                float t1y = (node.maxY[c] - ray.origin[1]) * ray.invDir[1];
+                float t0z = (node.minZ[c] - ray.origin[2]) * ray.invDir[2];
+                float t1z = (node.maxZ[c] - ray.origin[2]) * ray.invDir[2];
+                float tNear = std::max(std::max(std::min(t0x, t1x), std::min(t0y, t1y)), std::max(std::min(t0z, t1z), tMin));
+                float tFar = std::min(std::min(std::max(t0x, t1x), std::max(t0y, t1y)), std::min(std::max(t0z, t1z), tMax));
+                tEntry[i] = tNear;
+                if (tNear <= tFar)
+                    mask |= 1u << i;
+            }
+            return mask;
+#endif
+        }
+
+        static inline uint32_t intersectChildren(const Node &node, const RayData &ray, float tMin, float tMax, float *tEntry)
+        {
+#if WIDE_BVH_AVX
+            if (N == 8)
+            {
+                const __m256 ox = _mm256_set1_ps(ray.origin[0]);
+                const __m256 oy = _mm256_set1_ps(ray.origin[1]);
+                const __m256 oz = _mm256_set1_ps(ray.origin[2]);
+                const __m256 ix = _mm256_set1_ps(ray.invDir[0]);
+                const __m256 iy = _mm256_set1_ps(ray.invDir[1]);
+                const __m256 iz = _mm256_set1_ps(ray.invDir[2]);
+
+                __m256 t0x = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.minX), ox), ix);
+                __m256 t1x = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.maxX), ox), ix);
+                __m256 t0y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.minY), oy), iy);
+                __m256 t1y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.maxY), oy), iy);
+                __m256 t0z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.minZ), oz), iz);
+                __m256 t1z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.maxZ), oz), iz);
+
+                __m256 tNear = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(t0x, t1x), _mm256_min_ps(t0y, t1y)),
+                                             _mm256_max_ps(_mm256_min_ps(t0z, t1z), _mm256_set1_ps(tMin)));
+                __m256 tFar = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(t0x, t1x), _mm256_max_ps(t0y, t1y)),
+                                            _mm256_min_ps(_mm256_max_ps(t0z, t1z), _mm256_set1_ps(tMax)));
+
+                _mm256_storeu_ps(tEntry, tNear);
+                return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+            }
+#endif
+            uint32_t mask = intersect4(node, 0, ray, tMin, tMax, tEntry);
+            if (N == 8)
+                mask |= intersect4(node, 4, ray, tMin, tMax, tEntry + 4) << 4;
+            return mask;
+        }
+
+    public:
+        WideBVH() = default;
+
+        void build(const BVH &bvh);
+        // Copies child bounds from the binary hierarchy this was built from,
+        // after it has been refitted.
+        void refit(const BVH &bvh, int numThreads);
+
+        inline bool isEmpty() const { return m_nodes.empty(); }
+        const BVHStats &getStats() const { return m_stats; }
+
+        /**
+         * Same contract as BVH::isHit. Children of a node that are hit are
+         * pushed far to near, so the nearest child is visited first.
+         */
+        template <typename HitFunc>
+        bool isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo,
+                   HitFunc hitPrimitive, TraversalStats *stats = nullptr) const
+        {
+            if (m_nodes.empty())
+                return false;
+
+            RayData rayData;
+            for (int i = 0; i < 3; i++)
+            {
+                rayData.origin[i] = static_cast<float>(ray.origin[i]);
+                rayData.invDir[i] = static_cast<float>(1.0 / ray.direction[i]);
+            }
+
+            // Pads the far distance to absorb float rounding in the slab
+            // test (see PBRT, "Robust ray-bounds intersections").
+            const float farScale = 1.0f + 6.0f * FLT_EPSILON;
+            const float tMinF = static_cast<float>(tMin);
+
+            double closestHitDist = tMax;
+            bool isHit = false;
+            HitInfo tempHitInfo;
+
+            StackEntry stack[BVH::MAX_DEPTH * (N - 1) + 1];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = {0, 0, tMinF};
+
+            if (stats)
+                stats->rays++;
+
+            alignas(32) float tEntry[N];
+
+            while (stackSize > 0)
+            {
+                StackEntry entry = stack[--stackSize];
+                if (entry.dist > closestHitDist)
+                    continue;
+
+                if (entry.count > 0)
+                {
+                    for (uint32_t i = entry.child; i < entry.child + entry.count; i++)
+                    {
+                        if (stats)
+                            stats->primitivesTested++;
+                        if (hitPrimitive(m_primIndices[i], tMin, closestHitDist, tempHitInfo))
+                        {
+                            hitInfo = tempHitInfo;
+                            closestHitDist = tempHitInfo.distInRay;
+                            isHit = true;
+                        }
+                    }
+                    continue;
+                }
+
+                const Node &node = m_nodes[entry.child];
+                if (stats)
+                    stats->nodesVisited++;
+
+                float tMaxF = static_cast<float>(closestHitDist) * farScale;
+                uint32_t mask = intersectChildren(node, rayData, tMinF, tMaxF, tEntry);
+
+                // Insertion sort the hit children far to near onto the stack.
+                uint32_t first = stackSize;
+                for (int c = 0; c < N; c++)
+                {
+                    if (!(mask & (1u << c)) || node.child[c] == INVALID_CHILD)
+                        continue;
+
+                    StackEntry childEntry{node.child[c], node.count[c], tEntry[c]};
+                    uint32_t i = stackSize++;
+                    while (i > first && stack[i - 1].dist < childEntry.dist)
+                    {
+                        stack[i] = stack[i - 1];
+                        i--;
+                    }
+                    stack[i] = childEntry;
+                }
+            }
+
+            return isHit;
+        }
+
+        // Same contract as BVH::isOccluded.
+        template <typename OccludedFunc>
+        bool isOccluded(const Ray &ray, double tMin, double tMax,
+                        OccludedFunc occludedPrimitive, TraversalStats *stats = nullptr) const
+        {
+            if (m_nodes.empty())
+                return false;
+
+            RayData rayData;
+            for (int i = 0; i < 3; i++)
+            {
+                rayData.origin[i] = static_cast<float>(ray.origin[i]);
+                rayData.invDir[i] = static_cast<float>(1.0 / ray.direction[i]);
+            }
+
+            const float tMinF = static_cast<float>(tMin);
+            const float tMaxF = static_cast<float>(tMax) * (1.0f + 6.0f * FLT_EPSILON);
+
+            StackEntry stack[BVH::MAX_DEPTH * (N - 1) + 1];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = {0, 0, tMinF};
+
+            if (stats)
+                stats->rays++;
+
+            alignas(32) float tEntry[N];
+
+            while (stackSize > 0)
+            {
+                StackEntry entry = stack[--stackSize];
+                if (entry.count > 0)
+                {
+                    for (uint32_t i = entry.child; i < entry.child + entry.count; i++)
+                    {
+                        if (stats)
+                            stats->primitivesTested++;
+                        if (occludedPrimitive(m_primIndices[i], tMin, tMax))
+                            return true;
+                    }
+                    continue;
+                }
+
+                const Node &node = m_nodes[entry.child];
+                if (stats)
+                    stats->nodesVisited++;
+
+                uint32_t mask = intersectChildren(node, rayData, tMinF, tMaxF, tEntry);
+                for (int c = 0; c < N; c++)
+                {
+                    if ((mask & (1u << c)) && node.child[c] != INVALID_CHILD)
+                        stack[stackSize++] = {node.child[c], node.count[c], tEntry[c]};
+                }
+            }
+
+            return false;
+        }
+    };
+}
+
+#endif
@@ -6,6 +6,7 @@
 
 #include "../utils/hitinfo.h"
 #include "../material/material.h"
+#include "../accel/aabb.h"
 
 using std::vector;
 using std::shared_ptr;
@@ -16,15 +17,28 @@ namespace raytracer
     class Geometry
     {
     protected:
-        shared_ptr<Material> m_material;
+        // Index into the scene MaterialTable.
+        uint32_t m_materialIndex = NO_MATERIAL;
     public:
-        const shared_ptr<Material>& material = m_material;
-        
         Geometry() = default;
-        Geometry(shared_ptr<Material> material)
-         : m_material(material) {}
+        Geometry(uint32_t materialIndex)
+         : m_materialIndex(materialIndex) {}
+
+        uint32_t getMaterialIndex() const { return m_materialIndex; }
 
         virtual bool isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const = 0;
+        /**
+         * Visibility query for shadow and occlusion rays. Returns true if
+         * anything is hit in [tMin, tMax], stopping at the first hit found
+         * and computing no hit information. The default falls back to isHit.
+         */
+        virtual bool isOccluded(const Ray &ray, double tMin, double tMax) const
+        {
+            HitInfo hitInfo;
+            return isHit(ray, tMin, tMax, hitInfo);
+        }
+        // World space bounds used to build acceleration structures.
+        virtual AABB getBounds() const = 0;
     };
 }
 
@@ -1,32 +1,139 @@
 #include "geometry_list.h"
 
+#include <typeinfo>
+
 using namespace raytracer;
 
+namespace
+{
+    // Exact type match, so a subclass overriding isHit is never intersected
+    // as its base class.
+    GeometryKind getGeometryKind(const Geometry &geo)
+    {
+        const std::type_info &type = typeid(geo);
+        if (type == typeid(Sphere))
+            return GeometryKind::SPHERE;
+        if (type == typeid(Triangle))
+            return GeometryKind::TRIANGLE;
+        return GeometryKind::OTHER;
+    }
+}
+
 GeometryList &GeometryList::operator=(const GeometryList &geoListObj)
 {
     geoList = geoListObj.geoList;
+    m_kinds = geoListObj.m_kinds;
+    m_bvh = geoListObj.m_bvh;
     return *this;
 }
 
 void GeometryList::add(shared_ptr<Geometry> geo)
 {
     geoList.push_back(geo);
+    m_kinds.push_back(getGeometryKind(*geo));
+    m_bvh = BVH();
 }
 
 void GeometryList::clear()
 {
     geoList.clear();
+    m_kinds.clear();
+    m_bvh = BVH();
+}
+
+void GeometryList::buildBVH(const BVHSettings &settings)
+{
+    std::vector<AABB> bounds;
+    bounds.reserve(geoList.size());
+    for (const shared_ptr<Geometry> &g : geoList)
+        bounds.push_back(g->getBounds());
+
+    m_bvh.build(bounds, settings);
+}
+
+void GeometryList::refitBVH()
+{
+    if (m_bvh.isEmpty())
+        return;
+
+    std::vector<AABB> bounds;
+    bounds.reserve(geoList.size());
+    for (const shared_ptr<Geometry> &g : geoList)
+        bounds.push_back(g->getBounds());
+
+    if (m_bvh.refit(bounds) > m_bvh.getSettings().rebuildThreshold)
+    {
+        BVHSettings settings = m_bvh.getSettings();
+        m_bvh.build(bounds, settings);
+    }
+}
+
+// Nested lists write their own index first, so the outermost list wins.
+inline bool GeometryList::hitObject(uint32_t index, const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const
+{
+    const Geometry &geo = *geoList[index];
+    // Only meshes set the primitive, so it is cleared for the others. It is
+    // restored on a miss, since hitInfo may hold an earlier, closer hit.
+    uint32_t primitiveIndex = hitInfo.primitiveIndex;
+    hitInfo.primitiveIndex = 0;
+    bool isHit;
+#ifndef RAYTRACER_VIRTUAL_DISPATCH
+    switch (m_kinds[index])
+    {
+    case GeometryKind::SPHERE:
+        isHit = static_cast<const Sphere &>(geo).Sphere::isHit(ray, tMin, tMax, hitInfo);
+        break;
+    case GeometryKind::TRIANGLE:
+        isHit = static_cast<const Triangle &>(geo).Triangle::isHit(ray, tMin, tMax, hitInfo);
+        break;
+    case GeometryKind::OTHER:
+    default:
+        isHit = geo.isHit(ray, tMin, tMax, hitInfo);
+        break;
+    }
+#else
+    isHit = geo.isHit(ray, tMin, tMax, hitInfo);
+#endif
+    if (isHit)
+        hitInfo.objectIndex = index;
+    else
+        hitInfo.primitiveIndex = primitiveIndex;
+    return isHit;
+}
+
+inline bool GeometryList::occludedObject(uint32_t index, const Ray &ray, double tMin, double tMax) const
+{
+    const Geometry &geo = *geoList[index];
+#ifndef RAYTRACER_VIRTUAL_DISPATCH
+    switch (m_kinds[index])
+    {
+    case GeometryKind::SPHERE:
+        return static_cast<const Sphere &>(geo).Sphere::isOccluded(ray, tMin, tMax);
+    case GeometryKind::TRIANGLE:
+        return static_cast<const Triangle &>(geo).Triangle::isOccluded(ray, tMin, tMax);
+    case GeometryKind::OTHER:
+        break;
+    }
+#endif
+    return geo.isOccluded(ray, tMin, tMax);
 }
 
 bool GeometryList::isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const
 {
+    if (!m_bvh.isEmpty())
+    {
+        return m_bvh.isHit(ray, tMin, tMax, hitInfo,
+                           [this, &ray](uint32_t index, double tMin, double tMax, HitInfo &hit)
+                           { return hitObject(index, ray, tMin, tMax, hit); });
+    }
+
     HitInfo tempHitInfo;
     double closestHitDist = tMax;
     bool isHit = false;
 
-    for (const shared_ptr<Geometry> &g : geoList)
+    for (uint32_t i = 0; i < geoList.size(); i++)
     {
-        if (g->isHit(ray, tMin, closestHitDist, tempHitInfo))
+        if (hitObject(i, ray, tMin, closestHitDist, tempHitInfo))
         {
             hitInfo = tempHitInfo;
             closestHitDist = hitInfo.distInRay;
@@ -35,4 +142,33 @@ bool GeometryList::isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitI
     }
 
     return isHit;
-}
\ No newline at end of file
+}
+
+bool GeometryList::isOccluded(const Ray &ray, double tMin, double tMax) const
+{
+    if (!m_bvh.isEmpty())
+    {
+        return m_bvh.isOccluded(ray, tMin, tMax,
+                                [this, &ray](uint32_t index, double tMin, double tMax)
+                                { return occludedObject(index, ray, tMin, tMax); });
+    }
+
+    for (uint32_t i = 0; i < geoList.size(); i++)
+    {
+        if (occludedObject(i, ray, tMin, tMax))
+            return true;
+    }
+
+    return false;
+}
+
+AABB GeometryList::getBounds() const
+{
+    if (!m_bvh.isEmpty())
+        return m_bvh.getBounds();
+
+    AABB bounds;
+    for (const shared_ptr<Geometry> &g : geoList)
+        bounds.expand(g->getBounds());
+    return bounds;
+}
@@ -2,13 +2,44 @@
 #define GEOMETRY_LIST_H
 
 #include "geometry.h"
+#include "sphere.h"
+#include "triangle.h"
+#include "../accel/bvh.h"
+
+#include <cstdint>
 
 namespace raytracer
 {
+    // Geometry classes intersected without a virtual call. Anything else,
+    // including subclasses of these, is OTHER and goes through Geometry.
+    enum class GeometryKind : uint8_t
+    {
+        SPHERE,
+        TRIANGLE,
+        OTHER
+    };
+
+    /**
+     * @brief Collection of geometry. After buildBVH() is called, ray queries
+     * traverse a top-level BVH over the bounds of each object instead of
+     * testing every object. Adding geometry invalidates the BVH until it is
+     * built again.
+     *
+     * The kind of every object is recorded when it is added, and ray
+     * queries switch on it to call spheres and triangles directly, so their
+     * kernels can be inlined into the traversal loop. Define
+     * RAYTRACER_VIRTUAL_DISPATCH to always use the virtual calls instead.
+     */
     class GeometryList : public Geometry
     {
     private:
         vector<shared_ptr<Geometry>> geoList;
+        // Kind of each object in geoList.
+        vector<GeometryKind> m_kinds;
+        BVH m_bvh;
+
+        bool hitObject(uint32_t index, const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const;
+        bool occludedObject(uint32_t index, const Ray &ray, double tMin, double tMax) const;
     public:
         GeometryList() = default;
         GeometryList(shared_ptr<Geometry> geo) { add(geo); }
@@ -16,8 +47,19 @@ namespace raytracer
 
         void clear();
         void add(shared_ptr<Geometry> geo);
+        void buildBVH(const BVHSettings &settings = BVHSettings());
+        // Updates the BVH after objects in the list moved or deformed.
+        void refitBVH();
+        const BVH &getBVH() const { return m_bvh; }
+
+        uint32_t size() const { return static_cast<uint32_t>(geoList.size()); }
+        const Geometry &operator[](uint32_t index) const { return *geoList[index]; }
+        GeometryKind getKind(uint32_t index) const { return m_kinds[index]; }
+
         bool isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const override;
+        bool isOccluded(const Ray &ray, double tMin, double tMax) const override;
+        AABB getBounds() const override;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,61 @@
+#include "instance.h"
+
+using namespace raytracer;
+
+Instance::Instance(shared_ptr<Geometry> object, const Matrix4 &transform, uint32_t materialIndex)
+    : Geometry(materialIndex),
+      m_object{object},
+      m_transform{transform},
+      m_inverseTransform{transform.inverse()},
+      m_normalTransform{m_inverseTransform.transpose()} {}
+
+/**
+ * World bounds enclose the transformed corners of the object bounds. They are
+ * not cached, so they follow the object when it deforms.
+ */
+AABB Instance::getBounds() const
+{
+    AABB bounds;
+    AABB objectBounds = m_object->getBounds();
+    if (objectBounds.isEmpty())
+        return bounds;
+
+    for (int i = 0; i < 8; i++)
+    {
+        Point corner((i & 1) ? objectBounds.max[0] : objectBounds.min[0],
+                     (i & 2) ? objectBounds.max[1] : objectBounds.min[1],
+                     (i & 4) ? objectBounds.max[2] : objectBounds.min[2]);
+        bounds.expand(m_transform.transformPoint(corner));
+    }
+    return bounds;
+}
+
+/**
+ * The direction is transformed without normalizing, so a distance t along
+ * the object space ray is the same t along the world space ray and tMin/tMax
+ * carry over unchanged.
+ */
+bool Instance::isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const
+{
+    Ray objectRay(m_inverseTransform.transformPoint(ray.origin),
+                  m_inverseTransform.transformVector(ray.direction));
+
+    if (!m_object->isHit(objectRay, tMin, tMax, hitInfo))
+        return false;
+
+    // A linear map preserves the sign of dot(direction, normal), so the
+    // front face flag computed in object space is still valid.
+    hitInfo.point = ray.getPointAtDistance(hitInfo.distInRay);
+    hitInfo.normal = m_normalTransform.transformVector(hitInfo.normal).normalize();
+    if (m_materialIndex != NO_MATERIAL)
+        hitInfo.materialIndex = m_materialIndex;
+
+    return true;
+}
+
+bool Instance::isOccluded(const Ray &ray, double tMin, double tMax) const
+{
+    Ray objectRay(m_inverseTransform.transformPoint(ray.origin),
+                  m_inverseTransform.transformVector(ray.direction));
+    return m_object->isOccluded(objectRay, tMin, tMax);
+}
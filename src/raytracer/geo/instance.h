@@ -0,0 +1,40 @@
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include "../../math/math.h"
+#include "geometry.h"
+
+namespace raytracer
+{
+    using math::Matrix4;
+
+    /**
+     * @brief Places shared geometry (typically a Mesh with its own BVH) in the
+     * scene with an object-to-world transform. Rays are transformed into
+     * object space instead of transforming the geometry, so any number of
+     * instances share a single copy of the triangle data and hierarchy.
+     *
+     * If the instance is given a material it overrides the material of the
+     * referenced geometry.
+     */
+    class Instance : public Geometry
+    {
+    private:
+        shared_ptr<Geometry> m_object;
+        Matrix4 m_transform;
+        Matrix4 m_inverseTransform;
+        // Inverse transpose of the transform, for transforming normals.
+        Matrix4 m_normalTransform;
+
+    public:
+        Instance(shared_ptr<Geometry> object, const Matrix4 &transform, uint32_t materialIndex = NO_MATERIAL);
+
+        const Matrix4 &getTransform() const { return m_transform; }
+
+        bool isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const override;
+        bool isOccluded(const Ray &ray, double tMin, double tMax) const override;
+        AABB getBounds() const override;
+    };
+}
+
+#endif
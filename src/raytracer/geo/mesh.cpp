@@ -1,18 +1,167 @@
 #include "mesh.h"
+#include "../../utils/parallel.h"
+
+#include <stdexcept>
 
 using namespace raytracer;
 
-bool Mesh::isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const
+void Mesh::packTriangles()
+{
+    m_packedTriangles.resize(m_triangleMesh.getTriangleCount());
+    for (uint32_t i = 0; i < m_packedTriangles.size(); i++)
+    {
+        m_packedTriangles[i] = PackedTriangle(m_triangleMesh.getVertex(i, 0),
+                                              m_triangleMesh.getVertex(i, 1),
+                                              m_triangleMesh.getVertex(i, 2));
+    }
+}
+
+void Mesh::buildBVH(const BVHSettings &settings)
+{
+    std::vector<AABB> bounds(m_triangleMesh.getTriangleCount());
+    for (uint32_t i = 0; i < bounds.size(); i++)
+        bounds[i] = m_triangleMesh.getTriangleBounds(i);
+
+    buildBVH(settings, bounds);
+}
+
+void Mesh::buildBVH(const BVHSettings &settings, const std::vector<AABB> &bounds)
+{
+    m_bvh.build(bounds, settings,
+                [this](uint32_t index, const AABB &bounds, int axis, double position, AABB &left, AABB &right)
+                { m_triangleMesh.splitTriangleBounds(index, bounds, axis, position, left, right); });
+
+    if (settings.layout == BVHLayout::WIDE4)
+        m_bvh4.build(m_bvh);
+    else if (settings.layout == BVHLayout::WIDE8)
+        m_bvh8.build(m_bvh);
+}
+
+bool Mesh::updateVertexPositions(const vector<Point> &positions)
 {
-    HitInfo tempHitInfo;
-    for (const Triangle &t : m_triangles)
+    if (positions.size() != m_triangleMesh.positions.size())
+        throw std::invalid_argument("Mesh::updateVertexPositions expects one position per vertex");
+
+    const BVHSettings &settings = m_bvh.getSettings();
+    m_triangleMesh.positions = positions;
+
+    std::vector<AABB> bounds(m_triangleMesh.getTriangleCount());
+    parallelFor(settings.numThreads, static_cast<uint32_t>(bounds.size()), [&](uint32_t begin, uint32_t end, int)
+                {
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        bounds[i] = m_triangleMesh.getTriangleBounds(i);
+                        m_packedTriangles[i] = PackedTriangle(m_triangleMesh.getVertex(i, 0),
+                                                              m_triangleMesh.getVertex(i, 1),
+                                                              m_triangleMesh.getVertex(i, 2));
+                    } });
+
+    if (m_bvh.refit(bounds) > settings.rebuildThreshold)
     {
-        if (t.isHit(ray, tMin, tMax, tempHitInfo))
-        {
-            hitInfo = tempHitInfo;
-            return true;
-        }
+        // Copy, since building replaces the settings held by the BVH.
+        BVHSettings rebuildSettings = settings;
+        buildBVH(rebuildSettings, bounds);
+        return true;
     }
 
+    if (settings.layout == BVHLayout::WIDE4)
+        m_bvh4.refit(m_bvh, settings.numThreads);
+    else if (settings.layout == BVHLayout::WIDE8)
+        m_bvh8.refit(m_bvh, settings.numThreads);
+
     return false;
-}
\ No newline at end of file
+}
+
+const BVHStats &Mesh::getBVHStats() const
+{
+    switch (m_bvh.getSettings().layout)
+    {
+    case BVHLayout::WIDE4:
+        return m_bvh4.getStats();
+    case BVHLayout::WIDE8:
+        return m_bvh8.getStats();
+    case BVHLayout::BINARY:
+    default:
+        return m_bvh.getStats();
+    }
+}
+
+bool Mesh::hitTriangle(uint32_t index, const Ray &ray, const WatertightRay &watertightRay,
+                       double tMin, double tMax, HitInfo &hitInfo) const
+{
+    double t;
+    if (!m_packedTriangles[index].intersect(watertightRay, tMin, tMax, t))
+        return false;
+
+    hitInfo.point = ray.getPointAtDistance(t);
+    hitInfo.distInRay = t;
+    hitInfo.setFaceNormal(ray.direction, m_triangleMesh.getTriangleNormal(index));
+    hitInfo.materialIndex = m_materialIndex;
+    hitInfo.primitiveIndex = index;
+
+    return true;
+}
+
+template <typename HitFunc>
+bool Mesh::traverse(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo, HitFunc hitTriangle, TraversalStats *stats) const
+{
+    switch (m_bvh.getSettings().layout)
+    {
+    case BVHLayout::WIDE4:
+        return m_bvh4.isHit(ray, tMin, tMax, hitInfo, hitTriangle, stats);
+    case BVHLayout::WIDE8:
+        return m_bvh8.isHit(ray, tMin, tMax, hitInfo, hitTriangle, stats);
+    case BVHLayout::BINARY:
+    default:
+        return m_bvh.isHit(ray, tMin, tMax, hitInfo, hitTriangle, stats);
+    }
+}
+
+bool Mesh::isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const
+{
+    WatertightRay watertightRay(ray);
+    return traverse(ray, tMin, tMax, hitInfo,
+                    [this, &ray, &watertightRay](uint32_t index, double tMin, double tMax, HitInfo &hit)
+                    { return hitTriangle(index, ray, watertightRay, tMin, tMax, hit); },
+                    nullptr);
+}
+
+bool Mesh::isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo, TraversalStats &stats) const
+{
+    WatertightRay watertightRay(ray);
+    return traverse(ray, tMin, tMax, hitInfo,
+                    [this, &ray, &watertightRay](uint32_t index, double tMin, double tMax, HitInfo &hit)
+                    { return hitTriangle(index, ray, watertightRay, tMin, tMax, hit); },
+                    &stats);
+}
+
+bool Mesh::traverseOccluded(const Ray &ray, double tMin, double tMax, TraversalStats *stats) const
+{
+    WatertightRay watertightRay(ray);
+    auto isTriangleOccluded = [this, &watertightRay](uint32_t index, double tMin, double tMax)
+    {
+        double t;
+        return m_packedTriangles[index].intersect(watertightRay, tMin, tMax, t);
+    };
+
+    switch (m_bvh.getSettings().layout)
+    {
+    case BVHLayout::WIDE4:
+        return m_bvh4.isOccluded(ray, tMin, tMax, isTriangleOccluded, stats);
+    case BVHLayout::WIDE8:
+        return m_bvh8.isOccluded(ray, tMin, tMax, isTriangleOccluded, stats);
+    case BVHLayout::BINARY:
+    default:
+        return m_bvh.isOccluded(ray, tMin, tMax, isTriangleOccluded, stats);
+    }
+}
+
+bool Mesh::isOccluded(const Ray &ray, double tMin, double tMax) const
+{
+    return traverseOccluded(ray, tMin, tMax, nullptr);
+}
+
+bool Mesh::isOccluded(const Ray &ray, double tMin, double tMax, TraversalStats &stats) const
+{
+    return traverseOccluded(ray, tMin, tMax, &stats);
+}
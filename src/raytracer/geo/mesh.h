@@ -1,22 +1,73 @@
 #ifndef MESH_H
 #define MESH_H
 
-#include "triangle.h"
+#include "triangle_mesh.h"
+#include "watertight.h"
+#include "../accel/bvh.h"
+#include "../accel/wide_bvh.h"
 
 namespace raytracer
 {
+    /**
+     * @brief Triangle mesh with its own BVH. Triangles are stored indexed
+     * (see TriangleMesh) and all share the mesh material.
+     */
     class Mesh : public Geometry
     {
     protected:
-        vector<Triangle> m_triangles;
+        TriangleMesh m_triangleMesh;
+        // Single precision copy of every triangle, in triangle order, used
+        // for intersection.
+        vector<PackedTriangle> m_packedTriangles;
+        // The binary hierarchy is always built. Wide layouts are collapsed
+        // from it when selected in the BVH settings.
+        BVH m_bvh;
+        WideBVH<4> m_bvh4;
+        WideBVH<8> m_bvh8;
+
+        void packTriangles();
+        void buildBVH(const BVHSettings &settings);
+        void buildBVH(const BVHSettings &settings, const std::vector<AABB> &bounds);
+
+        bool hitTriangle(uint32_t index, const Ray &ray, const WatertightRay &watertightRay,
+                         double tMin, double tMax, HitInfo &hitInfo) const;
+        template <typename HitFunc>
+        bool traverse(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo, HitFunc hitTriangle, TraversalStats *stats) const;
+        bool traverseOccluded(const Ray &ray, double tMin, double tMax, TraversalStats *stats) const;
 
     public:
-        Mesh(shared_ptr<Material> material)
-        : Geometry(material) {}
-        Mesh(shared_ptr<Material> material, std::vector<Triangle> triangles)
-        : Geometry(material), m_triangles{triangles} {}
+        Mesh(uint32_t materialIndex)
+        : Geometry(materialIndex) {}
+        Mesh(uint32_t materialIndex, TriangleMesh triangleMesh, const BVHSettings &bvhSettings = BVHSettings())
+        : Geometry(materialIndex), m_triangleMesh{std::move(triangleMesh)}
+        {
+            packTriangles();
+            buildBVH(bvhSettings);
+        }
+
+        /**
+         * Moves the vertices, keeping the topology. positions holds the new
+         * position of every vertex, in vertex order. The BVH is refitted in
+         * place, or fully rebuilt when refitting has raised its SAH cost past
+         * BVHSettings::rebuildThreshold. Returns true if it was rebuilt.
+         *
+         * Must not be called while the mesh is being rendered. Instances and
+         * geometry lists holding the mesh need their BVH refitted afterwards.
+         */
+        bool updateVertexPositions(const vector<Point> &positions);
+
+        const TriangleMesh &getTriangleMesh() const { return m_triangleMesh; }
+        const BVH &getBVH() const { return m_bvh; }
+        // Stats of the hierarchy used for traversal.
+        const BVHStats &getBVHStats() const;
+
         bool isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const override;
+        // Same as isHit, additionally accumulating traversal counters into stats.
+        bool isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo, TraversalStats &stats) const;
+        bool isOccluded(const Ray &ray, double tMin, double tMax) const override;
+        bool isOccluded(const Ray &ray, double tMin, double tMax, TraversalStats &stats) const;
+        AABB getBounds() const override { return m_bvh.getBounds(); }
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -2,50 +2,64 @@
 
 using namespace raytracer;
 
-/**
- * Moller-Trumbore triangle-ray intersection algorithm
- */
-bool Triangle::isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const
+AABB Triangle::getBounds() const
 {
-    if (m_vertices.size() < 3 || m_vertices.size() > 3)
-        return false;
-    
-    double epsilon = 0.0001;
-
-    // Compute Normal
-    Vector3 edgeDir1 = m_vertices[1] - m_vertices[0];
-    Vector3 edgeDir2 = m_vertices[2] - m_vertices[0];
-
-    Vector3 h = Vector3::cross(ray.direction, edgeDir2);
-    double a = Vector3::dot(edgeDir1, h);
+    AABB bounds;
+    for (const Point &p : m_vertices)
+        bounds.expand(p);
+    return bounds;
+}
 
-    if (a > -epsilon && a < -epsilon)
-        return false;
+void Triangle::splitBounds(const AABB &bounds, int axis, double position, AABB &left, AABB &right) const
+{
+    if (m_vertices.size() != 3)
+    {
+        left = right = AABB();
+        return;
+    }
+    splitBounds(m_vertices[0], m_vertices[1], m_vertices[2], bounds, axis, position, left, right);
+}
 
-    double f = 1.0 / a;
-    Vector3 s = ray.origin - m_vertices[0];
-    double u = f * Vector3::dot(s, h);
+/**
+ * Walks the edges, adding every vertex to its side of the plane and every
+ * edge crossing to both sides, then clips the result to bounds.
+ */
+void Triangle::splitBounds(const Point &v0, const Point &v1, const Point &v2,
+                           const AABB &bounds, int axis, double position, AABB &left, AABB &right)
+{
+    left = AABB();
+    right = AABB();
 
-    if (u < 0.0 || u > 1.0)
-        return false;
+    const Point *corners[3] = {&v0, &v1, &v2};
+    for (int i = 0; i < 3; i++)
+    {
+        const Point &a = *corners[i];
+        const Point &b = *corners[(i + 1) % 3];
+        double pa = a[axis];
+        double pb = b[axis];
 
-    Vector3 q = Vector3::cross(s, edgeDir1);
-    double v = f * Vector3::dot(ray.direction, q);
+        if (pa <= position)
+            left.expand(a);
+        if (pa >= position)
+            right.expand(a);
 
-    if (v < 0.0 || u + v > 1.0)
-        return false;
+        if ((pa < position && pb > position) || (pa > position && pb < position))
+        {
+            Point crossing = a + (b - a) * ((position - pa) / (pb - pa));
+            crossing[axis] = position;
+            left.expand(crossing);
+            right.expand(crossing);
+        }
+    }
 
-    float t = f * Vector3::dot(edgeDir2, q);
-    if (t < epsilon)
-        return false;
-    else
-    {
-        hitInfo.point = ray.getPointAtDistance(t);
-        hitInfo.distInRay = t;
-        Vector3 normal = (m_normals[0] + m_normals[1] + m_normals[2]) / 3.0;
-        hitInfo.setFaceNormal(ray.direction, normal.normalize());
-        hitInfo.material = m_material;
+    left.clip(bounds);
+    right.clip(bounds);
+}
 
-        return true;
-    }
-}
\ No newline at end of file
+void Triangle::setVertices(const Point &v0, const Point &v1, const Point &v2)
+{
+    m_vertices.resize(3, Point::zero);
+    m_vertices[0] = v0;
+    m_vertices[1] = v1;
+    m_vertices[2] = v2;
+}
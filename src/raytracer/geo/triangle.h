@@ -21,13 +21,13 @@ namespace raytracer
         int m_materialId;
 
     public:
-        Triangle(shared_ptr<Material> material,
+        Triangle(uint32_t materialIndex,
                  vector<Point> vertices,
                  vector<Vector3> normals,
                  vector<Vector3> texCoords,
                  vector<Color> vertexColors,
                  int materialId)
-            : Geometry(material),
+            : Geometry(materialIndex),
               m_vertices{vertices},
               m_normals{normals},
               m_texCoords{texCoords},
@@ -35,7 +35,82 @@ namespace raytracer
               m_materialId{materialId} {}
 
         bool isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const override;
+        bool isOccluded(const Ray &ray, double tMin, double tMax) const override;
+        AABB getBounds() const override;
+        // Bounds of the parts of the triangle inside bounds on either side
+        // of the plane axis = position. See PrimitiveSplitFunc.
+        void splitBounds(const AABB &bounds, int axis, double position, AABB &left, AABB &right) const;
+
+        void setVertices(const Point &v0, const Point &v1, const Point &v2);
+        const vector<Point> &getVertices() const { return m_vertices; }
+
+        // Ray intersection and splitting of a triangle given by its corners,
+        // shared with TriangleMesh. intersect writes the hit distance.
+        static bool intersect(const Ray &ray, const Point &v0, const Point &v1, const Point &v2,
+                              double tMin, double tMax, double &t);
+        static void splitBounds(const Point &v0, const Point &v1, const Point &v2,
+                                const AABB &bounds, int axis, double position, AABB &left, AABB &right);
     };
+
+    /**
+     * Moller-Trumbore triangle-ray intersection algorithm
+     */
+    inline bool Triangle::intersect(const Ray &ray, const Point &v0, const Point &v1, const Point &v2,
+                                    double tMin, double tMax, double &t)
+    {
+        double epsilon = 0.0001;
+
+        // Compute Normal
+        Vector3 edgeDir1 = v1 - v0;
+        Vector3 edgeDir2 = v2 - v0;
+
+        Vector3 h = Vector3::cross(ray.direction, edgeDir2);
+        double a = Vector3::dot(edgeDir1, h);
+
+        // Ray parallel to the triangle plane. Not compared against epsilon, since
+        // a is scaled by the edge lengths and that would reject small triangles.
+        if (a == 0.0)
+            return false;
+
+        double f = 1.0 / a;
+        Vector3 s = ray.origin - v0;
+        double u = f * Vector3::dot(s, h);
+
+        if (u < 0.0 || u > 1.0)
+            return false;
+
+        Vector3 q = Vector3::cross(s, edgeDir1);
+        double v = f * Vector3::dot(ray.direction, q);
+
+        if (v < 0.0 || u + v > 1.0)
+            return false;
+
+        t = f * Vector3::dot(edgeDir2, q);
+        // Written so that a NaN distance from a degenerate triangle is rejected,
+        // which would otherwise disable closest hit culling in the BVH.
+        return (t >= tMin && t <= tMax) && t >= epsilon;
+    }
+
+    inline bool Triangle::isHit(const Ray &ray, double tMin, double tMax, HitInfo &hitInfo) const
+    {
+        double t;
+        if (m_vertices.size() != 3 || !intersect(ray, m_vertices[0], m_vertices[1], m_vertices[2], tMin, tMax, t))
+            return false;
+
+        hitInfo.point = ray.getPointAtDistance(t);
+        hitInfo.distInRay = t;
+        Vector3 normal = (m_normals[0] + m_normals[1] + m_normals[2]) / 3.0;
+        hitInfo.setFaceNormal(ray.direction, normal.normalize());
+        hitInfo.materialIndex = m_materialIndex;
+
+        return true;
+    }
+
+    inline bool Triangle::isOccluded(const Ray &ray, double tMin, double tMax) const
+    {
+        double t;
+        return m_vertices.size() == 3 && intersect(ray, m_vertices[0], m_vertices[1], m_vertices[2], tMin, tMax, t);
+    }
 }
 
 #endif
\ No newline at end of file
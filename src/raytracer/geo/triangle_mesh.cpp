@@ -0,0 +1,45 @@
+#include "triangle_mesh.h"
+
+using namespace raytracer;
+
+void TriangleMesh::addTriangle(uint32_t i0, uint32_t i1, uint32_t i2, int materialId)
+{
+    indices.push_back(i0);
+    indices.push_back(i1);
+    indices.push_back(i2);
+    materialIds.push_back(materialId);
+}
+
+AABB TriangleMesh::getTriangleBounds(uint32_t triangle) const
+{
+    AABB bounds;
+    for (int corner = 0; corner < 3; corner++)
+        bounds.expand(getVertex(triangle, corner));
+    return bounds;
+}
+
+Vector3 TriangleMesh::getTriangleNormal(uint32_t triangle) const
+{
+    const uint32_t *index = &indices[3 * static_cast<size_t>(triangle)];
+    Vector3 normal = normals.empty()
+                         ? Vector3::cross(positions[index[1]] - positions[index[0]], positions[index[2]] - positions[index[0]])
+                         : (normals[index[0]] + normals[index[1]] + normals[index[2]]) / 3.0;
+    return normal.normalize();
+}
+
+void TriangleMesh::splitTriangleBounds(uint32_t triangle, const AABB &bounds, int axis, double position,
+                                       AABB &left, AABB &right) const
+{
+    Triangle::splitBounds(getVertex(triangle, 0), getVertex(triangle, 1), getVertex(triangle, 2),
+                          bounds, axis, position, left, right);
+}
+
+size_t TriangleMesh::getMemoryUsage() const
+{
+    return positions.capacity() * sizeof(Point) +
+           normals.capacity() * sizeof(Vector3) +
+           texCoords.capacity() * sizeof(Vector3) +
+           colors.capacity() * sizeof(Color) +
+           indices.capacity() * sizeof(uint32_t) +
+           materialIds.capacity() * sizeof(int);
+}
@@ -0,0 +1,56 @@
+#ifndef TRIANGLE_MESH_H
+#define TRIANGLE_MESH_H
+
+#include "triangle.h"
+
+#include <cstdint>
+
+namespace raytracer
+{
+    /**
+     * @brief Indexed triangle storage. Every vertex attribute lives in its
+     * own array shared by all triangles, and a triangle is three 32-bit
+     * indices into them. Normals, texture coordinates and colors are
+     * optional: each array is either empty or as long as positions.
+     */
+    struct TriangleMesh
+    {
+        vector<Point> positions;
+        vector<Vector3> normals;
+        vector<Vector3> texCoords;
+        vector<Color> colors;
+        // Three vertex indices per triangle.
+        vector<uint32_t> indices;
+        // Material id per triangle, or empty.
+        vector<int> materialIds;
+
+        inline uint32_t getTriangleCount() const { return static_cast<uint32_t>(indices.size() / 3); }
+        inline uint32_t getVertexCount() const { return static_cast<uint32_t>(positions.size()); }
+
+        inline const Point &getVertex(uint32_t triangle, int corner) const
+        {
+            return positions[indices[3 * static_cast<size_t>(triangle) + corner]];
+        }
+
+        void addTriangle(uint32_t i0, uint32_t i1, uint32_t i2, int materialId = 0);
+
+        AABB getTriangleBounds(uint32_t triangle) const;
+        // Average of the vertex normals, or the geometric normal when the
+        // mesh has none.
+        Vector3 getTriangleNormal(uint32_t triangle) const;
+
+        inline bool intersect(uint32_t triangle, const Ray &ray, double tMin, double tMax, double &t) const
+        {
+            const uint32_t *index = &indices[3 * static_cast<size_t>(triangle)];
+            return Triangle::intersect(ray, positions[index[0]], positions[index[1]], positions[index[2]], tMin, tMax, t);
+        }
+
+        void splitTriangleBounds(uint32_t triangle, const AABB &bounds, int axis, double position,
+                                 AABB &left, AABB &right) const;
+
+        // Bytes held by the attribute and index arrays.
+        size_t getMemoryUsage() const;
+    };
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef WATERTIGHT_H
+#define WATERTIGHT_H
+
+#include "../utils/ray.h"
+
+#include <cmath>
+#include <utility>
+
+namespace raytracer
+{
+    /**
+     * @brief Per ray constants of the watertight ray-triangle test (Woop,
+     * Benthin and Wald, "Watertight Ray/Triangle Intersection", 2013).
+     *
+     * The ray is translated to the origin and sheared so that it points
+     * down +z. Triangles are then tested with 2D edge functions in that
+     * space. Edge functions of a shared edge are computed from the same
+     * values in the same order for both triangles, so a ray can never slip
+     * between them. Computed once per ray and reused for every triangle.
+     */
+    struct WatertightRay
+    {
+        float origin[3];
+        // Dimension the ray is mostly travelling along, and the other two.
+        int kx, ky, kz;
+        float shearX, shearY, shearZ;
+
+        WatertightRay(const Ray &ray)
+        {
+            for (int i = 0; i < 3; i++)
+                origin[i] = static_cast<float>(ray.origin[i]);
+
+            kz = 0;
+            for (int i = 1; i < 3; i++)
+                if (std::abs(ray.direction[i]) > std::abs(ray.direction[kz]))
+                    kz = i;
+            kx = (kz + 1) % 3;
+            ky = (kx + 1) % 3;
+            // Keeps the winding order, so front and back faces keep the sign
+            // of the determinant.
+            if (ray.direction[kz] < 0.0)
+                std::swap(kx, ky);
+
+            shearX = static_cast<float>(ray.direction[kx] / ray.direction[kz]);
+            shearY = static_cast<float>(ray.direction[ky] / ray.direction[kz]);
+            shearZ = static_cast<float>(1.0 / ray.direction[kz]);
+        }
+    };
+
+    /**
+     * @brief Single precision copy of the corners of a triangle, packed into
+     * one contiguous record for the watertight test.
+     *
+     * Corners are kept instead of a base vertex and two edges: rebuilding a
+     * shared corner from an edge rounds differently in the two triangles
+     * sharing it, which would reopen the cracks the test is meant to close.
+     */
+    struct PackedTriangle
+    {
+        float v[3][3];
+
+        PackedTriangle() = default;
+        PackedTriangle(const Point &v0, const Point &v1, const Point &v2)
+        {
+            const Point *corners[3] = {&v0, &v1, &v2};
+            for (int c = 0; c < 3; c++)
+                for (int i = 0; i < 3; i++)
+                    v[c][i] = static_cast<float>((*corners[c])[i]);
+        }
+
+        // Writes the hit distance. Both faces are hit.
+        inline bool intersect(const WatertightRay &ray, double tMin, double tMax, double &t) const
+        {
+            const int kx = ray.kx, ky = ray.ky, kz = ray.kz;
+
+            // Corners relative to the ray origin.
+            float a[3], b[3], c[3];
+            for (int i = 0; i < 3; i++)
+            {
+                a[i] = v[0][i] - ray.origin[i];
+                b[i] = v[1][i] - ray.origin[i];
+                c[i] = v[2][i] - ray.origin[i];
+            }
+
+            // Shear and scale into ray space.
+            float ax = a[kx] - ray.shearX * a[kz];
+            float ay = a[ky] - ray.shearY * a[kz];
+            float bx = b[kx] - ray.shearX * b[kz];
+            float by = b[ky] - ray.shearY * b[kz];
+            float cx = c[kx] - ray.shearX * c[kz];
+            float cy = c[ky] - ray.shearY * c[kz];
+
+            // Scaled barycentric coordinates from 2D edge functions.
+            float u = cx * by - cy * bx;
+            float v = ax * cy - ay * cx;
+            float w = bx * ay - by * ax;
+
+            // A ray through an edge or corner gives exactly 0, where float
+            // rounding could pick the wrong sign. Those are redone in double.
+            if (u == 0.0f || v == 0.0f || w == 0.0f)
+            {
+                u = static_cast<float>(static_cast<double>(cx) * by - static_cast<double>(cy) * bx);
+                v = static_cast<float>(static_cast<double>(ax) * cy - static_cast<double>(ay) * cx);
+                w = static_cast<float>(static_cast<double>(bx) * ay - static_cast<double>(by) * ax);
+            }
+
+            if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f))
+                return false;
+
+            float det = u + v + w;
+            if (det == 0.0f)
+                return false;
+
+            // Scaled hit distance, compared against the scaled range to avoid
+            // a division for misses.
+            float az = ray.shearZ * a[kz];
+            float bz = ray.shearZ * b[kz];
+            float cz = ray.shearZ * c[kz];
+            double scaledT = static_cast<double>(u * az + v * bz + w * cz);
+            double absDet = std::abs(static_cast<double>(det));
+            if (det < 0.0f)
+                scaledT = -scaledT;
+            if (!(scaledT >= tMin * absDet && scaledT <= tMax * absDet))
+                return false;
+
+            t = scaledT / absDet;
+            return true;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,117 @@
+#include "area_light.h"
+
+#include <cmath>
+
+using namespace raytracer;
+
+namespace
+{
+    /**
+     * The cone around the direction to the centre has half angle thetaMax,
+     * with sin(thetaMax) = radius / distance, and solid angle
+     * 2 pi (1 - cos(thetaMax)). 1 - cos(thetaMax) is computed as
+     * sin^2 / (1 + cos), which keeps its precision for small or distant
+     * spheres.
+     */
+    inline double getOneMinusCosThetaMax(double radiusSquared, double distanceSquared)
+    {
+        double sinThetaMaxSquared = radiusSquared / distanceSquared;
+        return sinThetaMaxSquared / (1.0 + std::sqrt(1.0 - sinThetaMaxSquared));
+    }
+}
+
+bool SphereLight::sample(const Point &point, const Sample2D &u, LightSample &lightSample) const
+{
+    Vector3 toCenter = m_origin - point;
+    double distanceSquared = toCenter.lengthSquared();
+    double radiusSquared = m_radius * m_radius;
+    if (distanceSquared <= radiusSquared)
+        return false;
+
+    double distance = std::sqrt(distanceSquared);
+    double oneMinusCosThetaMax = getOneMinusCosThetaMax(radiusSquared, distanceSquared);
+
+    double cosTheta = 1.0 - u.x * oneMinusCosThetaMax;
+    double sinThetaSquared = std::fmax(0.0, 1.0 - cosTheta * cosTheta);
+    double sinTheta = std::sqrt(sinThetaSquared);
+    double sinPhi, cosPhi;
+    math::sinCos2Pi(u.y, sinPhi, cosPhi);
+
+    Vector3 w = toCenter / distance;
+    Vector3 tangent, bitangent;
+    Vector3::orthonormalBasis(w, tangent, bitangent);
+    lightSample.direction = cosPhi * sinTheta * tangent + sinPhi * sinTheta * bitangent + cosTheta * w;
+
+    // Nearest intersection with the sphere along the sampled direction.
+    lightSample.distance = distance * cosTheta - std::sqrt(std::fmax(0.0, radiusSquared - distanceSquared * sinThetaSquared));
+    lightSample.radiance = m_radiance;
+    lightSample.pdf = 1.0 / (2.0 * math::PI * oneMinusCosThetaMax);
+    return true;
+}
+
+// Uniform over the cone, whichever point of the sphere was hit.
+double SphereLight::pdf(const Point &point, const Point &lightPoint) const
+{
+    double distanceSquared = (m_origin - point).lengthSquared();
+    double radiusSquared = m_radius * m_radius;
+    if (distanceSquared <= radiusSquared)
+        return 0.0;
+
+    return 1.0 / (2.0 * math::PI * getOneMinusCosThetaMax(radiusSquared, distanceSquared));
+}
+
+TriangleLight::TriangleLight(const Point &v0, const Point &v1, const Point &v2, Color radiance)
+    : AreaLight(radiance), m_v0{v0}, m_v1{v1}, m_v2{v2}
+{
+    Vector3 cross = Vector3::cross(v1 - v0, v2 - v0);
+    double length = cross.length();
+    m_area = 0.5 * length;
+    m_normal = length > 0.0 ? cross / length : Vector3::up;
+}
+
+/**
+ * Uniform barycentrics from the square root warp. The area density
+ * 1 / area becomes distance^2 / (cos * area) per unit solid angle, with cos
+ * the angle between the direction and the light normal.
+ */
+bool TriangleLight::sample(const Point &point, const Sample2D &u, LightSample &lightSample) const
+{
+    if (m_area <= 0.0)
+        return false;
+
+    double su = std::sqrt(u.x);
+    double b0 = 1.0 - su;
+    double b1 = u.y * su;
+    Point lightPoint = b0 * m_v0 + b1 * m_v1 + (1.0 - b0 - b1) * m_v2;
+
+    Vector3 toLight = lightPoint - point;
+    double distanceSquared = toLight.lengthSquared();
+    if (distanceSquared <= 0.0)
+        return false;
+
+    double distance = std::sqrt(distanceSquared);
+    lightSample.direction = toLight / distance;
+    double cosLight = std::fabs(Vector3::dot(m_normal, lightSample.direction));
+    if (cosLight <= 0.0)
+        return false;
+
+    lightSample.distance = distance;
+    lightSample.radiance = m_radiance;
+    lightSample.pdf = distanceSquared / (cosLight * m_area);
+    return true;
+}
+
+/**
+ * Uses the geometric normal, as sample does, and not the shading normal of
+ * a hit, so both strategies of MIS find the same density for a direction.
+ */
+double TriangleLight::pdf(const Point &point, const Point &lightPoint) const
+{
+    Vector3 toLight = lightPoint - point;
+    double distanceSquared = toLight.lengthSquared();
+    double cosLight = std::fabs(Vector3::dot(m_normal, toLight)) / std::sqrt(distanceSquared);
+    if (m_area <= 0.0 || cosLight <= 0.0)
+        return 0.0;
+
+    return distanceSquared / (cosLight * m_area);
+}
@@ -0,0 +1,98 @@
+#ifndef AREA_LIGHT_H
+#define AREA_LIGHT_H
+
+#include "../../math/math.h"
+#include "../sampler/sampler.h"
+
+using math::Color;
+using math::Point;
+using math::Vector3;
+
+namespace raytracer
+{
+    // Direction towards a point sampled on a light, seen from a shaded point.
+    struct LightSample
+    {
+        // Unit direction from the shaded point to the light.
+        Vector3 direction = Vector3::zero;
+        // Distance to the sampled point along direction.
+        double distance = 0.0;
+        Color radiance = Color::zero;
+        // Probability density of direction, per unit solid angle.
+        double pdf = 0.0;
+    };
+
+    /**
+     * @brief Emissive surface that can be sampled directly. Lights are
+     * copies of the emissive geometry of a scene, kept by LightList.
+     */
+    class AreaLight
+    {
+    protected:
+        Color m_radiance;
+
+    public:
+        AreaLight(Color radiance)
+            : m_radiance{radiance} {}
+        virtual ~AreaLight() = default;
+
+        const Color &getRadiance() const { return m_radiance; }
+        virtual double getArea() const = 0;
+
+        /**
+         * Samples a direction from point towards the light with the 2D
+         * sample u. Returns false if the light can not be seen from point.
+         */
+        virtual bool sample(const Point &point, const Sample2D &u, LightSample &lightSample) const = 0;
+
+        /**
+         * Probability density per unit solid angle of sample picking the
+         * direction from point to lightPoint, a point on the light.
+         */
+        virtual double pdf(const Point &point, const Point &lightPoint) const = 0;
+    };
+
+    /**
+     * @brief Sphere light. Directions are sampled uniformly in the cone the
+     * sphere subtends from the shaded point, so no samples are wasted on
+     * the far side of the sphere.
+     */
+    class SphereLight : public AreaLight
+    {
+    private:
+        Point m_origin;
+        double m_radius;
+
+    public:
+        SphereLight(const Point &origin, double radius, Color radiance)
+            : AreaLight(radiance), m_origin{origin}, m_radius{radius} {}
+
+        double getArea() const override { return 4.0 * math::PI * m_radius * m_radius; }
+        bool sample(const Point &point, const Sample2D &u, LightSample &lightSample) const override;
+        double pdf(const Point &point, const Point &lightPoint) const override;
+    };
+
+    /**
+     * @brief Triangle light, emitting on both sides. Points are sampled
+     * uniformly over its area.
+     */
+    class TriangleLight : public AreaLight
+    {
+    private:
+        Point m_v0;
+        Point m_v1;
+        Point m_v2;
+        // Unit geometric normal.
+        Vector3 m_normal;
+        double m_area;
+
+    public:
+        TriangleLight(const Point &v0, const Point &v1, const Point &v2, Color radiance);
+
+        double getArea() const override { return m_area; }
+        bool sample(const Point &point, const Sample2D &u, LightSample &lightSample) const override;
+        double pdf(const Point &point, const Point &lightPoint) const override;
+    };
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include "light_list.h"
+#include "../geo/mesh.h"
+
+#include <algorithm>
+
+using namespace raytracer;
+
+namespace
+{
+    double getLuminance(const Color &color)
+    {
+        return 0.2126 * color.x() + 0.7152 * color.y() + 0.0722 * color.z();
+    }
+}
+
+uint32_t LightList::add(std::unique_ptr<AreaLight> light)
+{
+    if (getLuminance(light->getRadiance()) <= 0.0 || light->getArea() <= 0.0)
+        return NO_LIGHT;
+
+    m_lights.push_back(std::move(light));
+    return size() - 1;
+}
+
+void LightList::build(const GeometryList &geometry, const MaterialTable &materials)
+{
+    clear();
+    m_objectLights.assign(geometry.size(), NO_LIGHT);
+
+    HitInfo hitInfo;
+    for (uint32_t i = 0; i < geometry.size(); i++)
+    {
+        const Geometry &geo = geometry[i];
+        uint32_t firstPrimitive = static_cast<uint32_t>(m_primitiveLights.size());
+        uint32_t materialIndex = geo.getMaterialIndex();
+        if (materialIndex == NO_MATERIAL)
+            continue;
+
+        // Emission may depend on the hit, but lights have a single radiance.
+        // Taken at a default hit record.
+        hitInfo.materialIndex = materialIndex;
+        Color radiance = materials.emitted(materialIndex, hitInfo);
+        if (getLuminance(radiance) <= 0.0)
+            continue;
+
+        if (geometry.getKind(i) == GeometryKind::SPHERE)
+        {
+            const Sphere &sphere = static_cast<const Sphere &>(geo);
+            m_primitiveLights.push_back(add(std::make_unique<SphereLight>(sphere.origin, sphere.radius, radiance)));
+        }
+        else if (geometry.getKind(i) == GeometryKind::TRIANGLE)
+        {
+            const vector<Point> &vertices = static_cast<const Triangle &>(geo).getVertices();
+            if (vertices.size() == 3)
+                m_primitiveLights.push_back(add(std::make_unique<TriangleLight>(vertices[0], vertices[1], vertices[2], radiance)));
+        }
+        else if (const Mesh *mesh = dynamic_cast<const Mesh *>(&geo))
+        {
+            const TriangleMesh &triangleMesh = mesh->getTriangleMesh();
+            for (uint32_t t = 0; t < triangleMesh.getTriangleCount(); t++)
+                m_primitiveLights.push_back(add(std::make_unique<TriangleLight>(triangleMesh.getVertex(t, 0), triangleMesh.getVertex(t, 1),
+                                                                                triangleMesh.getVertex(t, 2), radiance)));
+        }
+
+        if (m_primitiveLights.size() > firstPrimitive)
+            m_objectLights[i] = firstPrimitive;
+    }
+
+    buildDistribution();
+}
+
+void LightList::buildDistribution()
+{
+    m_cdf.resize(m_lights.size());
+    double total = 0.0;
+    for (size_t i = 0; i < m_lights.size(); i++)
+    {
+        total += m_lights[i]->getArea() * getLuminance(m_lights[i]->getRadiance());
+        m_cdf[i] = total;
+    }
+    for (double &value : m_cdf)
+        value /= total;
+}
+
+void LightList::clear()
+{
+    m_lights.clear();
+    m_cdf.clear();
+    m_objectLights.clear();
+    m_primitiveLights.clear();
+}
+
+bool LightList::sample(const Point &point, double uLight, const Sample2D &u, LightSample &lightSample) const
+{
+    if (m_lights.empty())
+        return false;
+
+    size_t index = std::upper_bound(m_cdf.begin(), m_cdf.end(), uLight) - m_cdf.begin();
+    index = std::min(index, m_lights.size() - 1);
+    if (!m_lights[index]->sample(point, u, lightSample))
+        return false;
+
+    lightSample.pdf *= getPickPdf(static_cast<uint32_t>(index));
+    return true;
+}
+
+// Finds the light made from the hit triangle of a mesh, so its own
+// geometric normal is used rather than the shading normal of the hit.
+double LightList::pdf(const Point &point, const HitInfo &lightHit) const
+{
+    if (lightHit.objectIndex >= m_objectLights.size())
+        return 0.0;
+
+    uint32_t firstPrimitive = m_objectLights[lightHit.objectIndex];
+    if (firstPrimitive == NO_LIGHT)
+        return 0.0;
+
+    uint32_t primitive = firstPrimitive + lightHit.primitiveIndex;
+    if (primitive >= m_primitiveLights.size())
+        return 0.0;
+
+    uint32_t index = m_primitiveLights[primitive];
+    if (index == NO_LIGHT)
+        return 0.0;
+
+    return getPickPdf(index) * m_lights[index]->pdf(point, lightHit.point);
+}
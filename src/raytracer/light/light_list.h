@@ -0,0 +1,69 @@
+#ifndef LIGHT_LIST_H
+#define LIGHT_LIST_H
+
+#include "area_light.h"
+#include "../geo/geometry_list.h"
+#include "../material/material_table.h"
+
+#include <memory>
+#include <vector>
+
+namespace raytracer
+{
+    /**
+     * @brief Area lights of a scene, for next event estimation. A light is
+     * picked with a probability proportional to its power, its area times
+     * the luminance of its radiance, so bright and large lights get most
+     * of the shadow rays.
+     */
+    class LightList
+    {
+    private:
+        std::vector<std::unique_ptr<AreaLight>> m_lights;
+        // Running sum of the light powers, normalized to end at 1.
+        std::vector<double> m_cdf;
+        // Offset of the first primitive of each object of the geometry list
+        // in m_primitiveLights, or NO_LIGHT if the object does not emit.
+        std::vector<uint32_t> m_objectLights;
+        // Light made from each triangle of an emissive mesh, or from an
+        // emissive sphere or triangle, or NO_LIGHT if it was dropped.
+        std::vector<uint32_t> m_primitiveLights;
+
+        // Returns the index of the light, or NO_LIGHT if it does not emit.
+        uint32_t add(std::unique_ptr<AreaLight> light);
+        void buildDistribution();
+        double getPickPdf(uint32_t index) const { return m_cdf[index] - (index > 0 ? m_cdf[index - 1] : 0.0); }
+
+    public:
+        static constexpr uint32_t NO_LIGHT = UINT32_MAX;
+
+        /**
+         * Replaces the lights with the emissive spheres, triangles and mesh
+         * triangles among the objects of geometry. Instanced geometry does
+         * not become a light, though it still emits when hit.
+         */
+        void build(const GeometryList &geometry, const MaterialTable &materials);
+        void clear();
+
+        bool isEmpty() const { return m_lights.empty(); }
+        uint32_t size() const { return static_cast<uint32_t>(m_lights.size()); }
+        const AreaLight &operator[](uint32_t index) const { return *m_lights[index]; }
+
+        /**
+         * Picks a light with the 1D sample uLight and samples a direction
+         * towards it with u. The pdf of the sample includes the probability
+         * of picking the light. Returns false if there is no light to pick
+         * or it can not be seen from point.
+         */
+        bool sample(const Point &point, double uLight, const Sample2D &u, LightSample &lightSample) const;
+
+        /**
+         * Density per unit solid angle of sample picking the direction from
+         * point to lightHit, a hit on an object of the geometry the lights
+         * were built from. 0 if that object is not a light.
+         */
+        double pdf(const Point &point, const HitInfo &lightHit) const;
+    };
+}
+
+#endif
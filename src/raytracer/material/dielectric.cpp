@@ -2,21 +2,6 @@
 
 using raytracer::Dielectric;
 
-bool Dielectric::scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut) const
-{
-
-    Vector3 dir = refract(rayIn.direction.normalize(),
-                          hitInfo.normal,
-                          hitInfo.isFrontFace
-                              ? m_ior
-                              : 1.0 / m_ior);
-
-    rayOut = Ray(hitInfo.point, dir);
-    atten = Color::one;
-
-    return true;
-}
-
 /**
  * Snell's law for refraction:
  * i*sinθ=i'*sinθ', where i is refractive index of incident ray, θ is the angle
@@ -35,7 +20,7 @@ bool Dielectric::scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Colo
  * 
  * i = 1.0 (Refractive index of air)
  */
-Vector3 Dielectric::refract(const Vector3 &v, const Vector3 &normal, double ior) const
+Vector3 Dielectric::refract(const Vector3 &v, const Vector3 &normal, double ior, double u) const
 {
     double cosTheta = fmin(Vector3::dot(-v, normal), 1.0);
     double sinTheta = sqrt(1 - cosTheta * cosTheta);
@@ -45,7 +30,7 @@ Vector3 Dielectric::refract(const Vector3 &v, const Vector3 &normal, double ior)
     Vector3 refractY = -sqrt(fabs(1 - refractX.lengthSquared())) * normal;
 
     bool isReflectedRay = iorRatio * sinTheta > 1.0;
-    if (isReflectedRay || (reflectance(cosTheta, iorRatio) > math::random()))
+    if (isReflectedRay || (reflectance(cosTheta, iorRatio) > u))
         return Vector3::reflect(v, normal);
     else
         return refractX + refractY;
@@ -8,7 +8,8 @@ namespace raytracer
     class Dielectric : public Material
     {
     private:
-        Vector3 refract(const Vector3 &v, const Vector3 &normal, double ior) const;
+        // u in [0, 1) picks between reflection and refraction.
+        Vector3 refract(const Vector3 &v, const Vector3 &normal, double ior, double u) const;
         double reflectance(double cosTheta, double iorRatio) const; 
     protected:
         double m_ior = 1.45;
@@ -19,8 +20,23 @@ namespace raytracer
         Dielectric(Color color, double ior = 1.45)
             : Material(color), m_ior{ior} {}
 
-        bool scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut) const override;
+        bool scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut, Sampler &sampler) const override;
     };
+
+    inline bool Dielectric::scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut, Sampler &sampler) const
+    {
+        Vector3 dir = refract(rayIn.direction.normalize(),
+                              hitInfo.normal,
+                              hitInfo.isFrontFace
+                                  ? m_ior
+                                  : 1.0 / m_ior,
+                              sampler.get1D());
+
+        rayOut = Ray(hitInfo.point, dir);
+        atten = Color::one;
+
+        return true;
+    }
 }
 
 #endif
\ No newline at end of file
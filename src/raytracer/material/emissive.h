@@ -0,0 +1,39 @@
+#ifndef EMISSIVE_H
+#define EMISSIVE_H
+
+#include "material.h"
+
+namespace raytracer
+{
+    /**
+     * @brief Light emitting surface. Emits color * intensity on both sides
+     * and absorbs every ray that hits it. Spheres, triangles and meshes
+     * with this material become area lights of the scene (see LightList).
+     */
+    class Emissive : public Material
+    {
+    protected:
+        double m_intensity = 1.0;
+
+    public:
+        double &intensity = m_intensity;
+
+        Emissive(Color color, double intensity = 1.0)
+            : Material(color), m_intensity{intensity} {}
+
+        bool scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut, Sampler &sampler) const override;
+        Color emitted(const HitInfo &hitInfo) const override;
+    };
+
+    inline bool Emissive::scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut, Sampler &sampler) const
+    {
+        return false;
+    }
+
+    inline Color Emissive::emitted(const HitInfo &hitInfo) const
+    {
+        return m_color * m_intensity;
+    }
+}
+
+#endif
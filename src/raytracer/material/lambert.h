@@ -12,8 +12,40 @@ namespace raytracer
         Lambert(Color albedo)
             : Material(albedo) {}
 
-        bool scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut) const override;
+        bool scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut, Sampler &sampler) const override;
+        bool isSpecular() const override { return false; }
+        Color eval(const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const override;
+        double pdf(const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const override;
     };
+
+    inline bool Lambert::scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut, Sampler &sampler) const
+    {
+        Sample2D u = sampler.get2D();
+        Vector3 local = Vector3::sampleCosineHemisphere(u.x, u.y);
+
+        // Local frame with the normal as z.
+        Vector3 tangent, bitangent;
+        Vector3::orthonormalBasis(hitInfo.normal, tangent, bitangent);
+        Vector3 dir = local.x() * tangent + local.y() * bitangent + local.z() * hitInfo.normal;
+
+        rayOut = Ray(hitInfo.point, dir);
+        atten = m_color;
+
+        return true;
+    }
+
+    // scatterRay samples the cosine distribution, cos / pi. The BSDF is
+    // m_color / pi.
+    inline double Lambert::pdf(const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const
+    {
+        double cosTheta = Vector3::dot(hitInfo.normal, direction.normalize());
+        return cosTheta > 0.0 ? cosTheta / math::PI : 0.0;
+    }
+
+    inline Color Lambert::eval(const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const
+    {
+        return m_color * pdf(rayIn, hitInfo, direction);
+    }
 }
 
 #endif
\ No newline at end of file
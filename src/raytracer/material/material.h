@@ -2,6 +2,7 @@
 #define MATERIAL_H
 
 #include "../utils/hitinfo.h"
+#include "../sampler/sampler.h"
 
 #include <cmath>
 
@@ -20,7 +21,37 @@ namespace raytracer
         Material(Color color)
             : m_color{color} {}
 
-        virtual bool scatterRay(const Ray &rayIn, const HitInfo &hitInfo, Color &atten, Ray &rayOut) const = 0;
+        /**
+         * Picks the direction the ray continues in after hitting the surface,
+         * drawing its random numbers from the current bounce dimensions of
+         * sampler. Returns false if the ray is absorbed.
+         */
+        virtual bool scatterRay(const Ray &rayIn, const HitInfo &hitInfo, Color &atten, Ray &rayOut, Sampler &sampler) const = 0;
+
+        // Radiance given off at the hit point. Black unless overridden.
+        virtual Color emitted(const HitInfo &hitInfo) const { return Color::zero; }
+
+        /**
+         * Specular materials scatter into directions picked from a delta
+         * distribution, or one that eval and pdf do not describe. Lights
+         * are only sampled directly at surfaces that are not specular.
+         */
+        virtual bool isSpecular() const { return true; }
+
+        /**
+         * Light scattered from direction into the direction opposite rayIn,
+         * per unit of incoming radiance and solid angle: the BSDF times the
+         * cosine at the surface. direction need not be normalized. Only
+         * meaningful for materials that are not specular.
+         */
+        virtual Color eval(const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const { return Color::zero; }
+
+        /**
+         * Probability density per unit solid angle of scatterRay picking
+         * direction. scatterRay sets atten to eval / pdf. Only meaningful
+         * for materials that are not specular.
+         */
+        virtual double pdf(const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const { return 0.0; }
     };
 }
 
@@ -0,0 +1,46 @@
+#include "material_table.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <typeinfo>
+
+using namespace raytracer;
+
+namespace
+{
+    // Exact type match, so a subclass overriding scatterRay is never shaded
+    // as its base class.
+    MaterialKind getMaterialKind(const Material &material)
+    {
+        const std::type_info &type = typeid(material);
+        if (type == typeid(Lambert))
+            return MaterialKind::LAMBERT;
+        if (type == typeid(Metallic))
+            return MaterialKind::METALLIC;
+        if (type == typeid(Dielectric))
+            return MaterialKind::DIELECTRIC;
+        if (type == typeid(Emissive))
+            return MaterialKind::EMISSIVE;
+        return MaterialKind::OTHER;
+    }
+}
+
+uint32_t MaterialTable::add(std::shared_ptr<Material> material)
+{
+    if (!material)
+        throw std::invalid_argument("MaterialTable::add: material is null");
+
+    auto found = std::find(m_materials.begin(), m_materials.end(), material);
+    if (found != m_materials.end())
+        return static_cast<uint32_t>(found - m_materials.begin());
+
+    m_kinds.push_back(getMaterialKind(*material));
+    m_materials.push_back(std::move(material));
+    return static_cast<uint32_t>(m_materials.size() - 1);
+}
+
+void MaterialTable::clear()
+{
+    m_materials.clear();
+    m_kinds.clear();
+}
@@ -0,0 +1,166 @@
+#ifndef MATERIAL_TABLE_H
+#define MATERIAL_TABLE_H
+
+#include "lambert.h"
+#include "metallic.h"
+#include "dielectric.h"
+#include "emissive.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace raytracer
+{
+    // Material classes shaded without a virtual call. Anything else, including
+    // subclasses of these, is OTHER and goes through Material::scatterRay.
+    enum class MaterialKind : uint8_t
+    {
+        LAMBERT,
+        METALLIC,
+        DIELECTRIC,
+        EMISSIVE,
+        OTHER
+    };
+
+    /**
+     * @brief Flat table owning every material of a scene. Geometry and hit
+     * records refer to materials by their 32-bit index in the table, so
+     * intersection code copies a plain integer instead of a reference
+     * counted pointer, and the material is looked up once per closest hit.
+     *
+     * The kind of every material is recorded when it is added, and
+     * its methods switch on it to call the built in materials directly, so
+     * their kernels can be inlined. Define RAYTRACER_VIRTUAL_DISPATCH to
+     * always use the virtual call instead.
+     */
+    class MaterialTable
+    {
+    private:
+        std::vector<std::shared_ptr<Material>> m_materials;
+        std::vector<MaterialKind> m_kinds;
+
+    public:
+        // Adds the material and returns its index. Adding a material that is
+        // already in the table returns its existing index.
+        uint32_t add(std::shared_ptr<Material> material);
+        void clear();
+
+        uint32_t size() const { return static_cast<uint32_t>(m_materials.size()); }
+        const Material &operator[](uint32_t index) const { return *m_materials[index]; }
+        MaterialKind getKind(uint32_t index) const { return m_kinds[index]; }
+
+        // Material::scatterRay of the material at index.
+        bool scatterRay(uint32_t index, const Ray &rayIn, const HitInfo &hitInfo, Color &atten, Ray &rayOut, Sampler &sampler) const;
+        // Material::emitted of the material at index.
+        Color emitted(uint32_t index, const HitInfo &hitInfo) const;
+        // Material::isSpecular of the material at index.
+        bool isSpecular(uint32_t index) const;
+        // Material::eval of the material at index.
+        Color eval(uint32_t index, const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const;
+        // Material::pdf of the material at index.
+        double pdf(uint32_t index, const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const;
+    };
+
+    inline bool MaterialTable::scatterRay(uint32_t index, const Ray &rayIn, const HitInfo &hitInfo, Color &atten, Ray &rayOut, Sampler &sampler) const
+    {
+        const Material &material = *m_materials[index];
+#ifndef RAYTRACER_VIRTUAL_DISPATCH
+        switch (m_kinds[index])
+        {
+        case MaterialKind::LAMBERT:
+            return static_cast<const Lambert &>(material).Lambert::scatterRay(rayIn, hitInfo, atten, rayOut, sampler);
+        case MaterialKind::METALLIC:
+            return static_cast<const Metallic &>(material).Metallic::scatterRay(rayIn, hitInfo, atten, rayOut, sampler);
+        case MaterialKind::DIELECTRIC:
+            return static_cast<const Dielectric &>(material).Dielectric::scatterRay(rayIn, hitInfo, atten, rayOut, sampler);
+        case MaterialKind::EMISSIVE:
+            return false;
+        case MaterialKind::OTHER:
+            break;
+        }
+#endif
+        return material.scatterRay(rayIn, hitInfo, atten, rayOut, sampler);
+    }
+
+    inline Color MaterialTable::emitted(uint32_t index, const HitInfo &hitInfo) const
+    {
+        const Material &material = *m_materials[index];
+#ifndef RAYTRACER_VIRTUAL_DISPATCH
+        switch (m_kinds[index])
+        {
+        case MaterialKind::LAMBERT:
+        case MaterialKind::METALLIC:
+        case MaterialKind::DIELECTRIC:
+            return Color::zero;
+        case MaterialKind::EMISSIVE:
+            return static_cast<const Emissive &>(material).Emissive::emitted(hitInfo);
+        case MaterialKind::OTHER:
+            break;
+        }
+#endif
+        return material.emitted(hitInfo);
+    }
+
+    inline bool MaterialTable::isSpecular(uint32_t index) const
+    {
+        const Material &material = *m_materials[index];
+#ifndef RAYTRACER_VIRTUAL_DISPATCH
+        switch (m_kinds[index])
+        {
+        case MaterialKind::LAMBERT:
+            return false;
+        case MaterialKind::METALLIC:
+            return static_cast<const Metallic &>(material).Metallic::isSpecular();
+        case MaterialKind::DIELECTRIC:
+        case MaterialKind::EMISSIVE:
+            return true;
+        case MaterialKind::OTHER:
+            break;
+        }
+#endif
+        return material.isSpecular();
+    }
+
+    inline Color MaterialTable::eval(uint32_t index, const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const
+    {
+        const Material &material = *m_materials[index];
+#ifndef RAYTRACER_VIRTUAL_DISPATCH
+        switch (m_kinds[index])
+        {
+        case MaterialKind::LAMBERT:
+            return static_cast<const Lambert &>(material).Lambert::eval(rayIn, hitInfo, direction);
+        case MaterialKind::METALLIC:
+            return static_cast<const Metallic &>(material).Metallic::eval(rayIn, hitInfo, direction);
+        case MaterialKind::DIELECTRIC:
+        case MaterialKind::EMISSIVE:
+            return Color::zero;
+        case MaterialKind::OTHER:
+            break;
+        }
+#endif
+        return material.eval(rayIn, hitInfo, direction);
+    }
+
+    inline double MaterialTable::pdf(uint32_t index, const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const
+    {
+        const Material &material = *m_materials[index];
+#ifndef RAYTRACER_VIRTUAL_DISPATCH
+        switch (m_kinds[index])
+        {
+        case MaterialKind::LAMBERT:
+            return static_cast<const Lambert &>(material).Lambert::pdf(rayIn, hitInfo, direction);
+        case MaterialKind::METALLIC:
+            return static_cast<const Metallic &>(material).Metallic::pdf(rayIn, hitInfo, direction);
+        case MaterialKind::DIELECTRIC:
+        case MaterialKind::EMISSIVE:
+            return 0.0;
+        case MaterialKind::OTHER:
+            break;
+        }
+#endif
+        return material.pdf(rayIn, hitInfo, direction);
+    }
+}
+
+#endif
@@ -16,8 +16,59 @@ namespace raytracer
         Metallic(Color color, double roughness = 0.5)
             : Material(color), m_roughness{math::clamp(roughness, 0.0, 1.0)} {}
 
-        bool scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut) const override;
+        bool scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut, Sampler &sampler) const override;
+        // Below this roughness the reflection is treated as a mirror.
+        static constexpr double SPECULAR_ROUGHNESS = 1e-3;
+        bool isSpecular() const override { return m_roughness < SPECULAR_ROUGHNESS; }
+        Color eval(const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const override;
+        double pdf(const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const override;
     };
+
+    inline bool Metallic::scatterRay(const Ray &rayIn, const HitInfo &hitInfo, math::Color &atten, Ray &rayOut, Sampler &sampler) const
+    {
+        Vector3 dir = Vector3::reflect(rayIn.direction.normalize(), hitInfo.normal);
+        Sample2D u = sampler.get2D();
+        dir += m_roughness * Vector3::sampleSpherical(u.x, u.y);
+
+        rayOut = Ray(hitInfo.point, dir);
+        atten = m_color;
+
+        return Vector3::dot(hitInfo.normal, rayOut.direction) > 0.0;
+    }
+
+    /**
+     * scatterRay offsets the unit mirror direction r by a point on the
+     * sphere of radius roughness, so a direction w is picked where the ray
+     * t * w crosses that sphere, at t = r•w ± sqrt((r•w)^2 - 1 + roughness^2).
+     * Converting the uniform area density 1 / (4 pi roughness^2) at each
+     * crossing to solid angle, with cos = sqrt(disc) / roughness, gives
+     * t^2 / (4 pi roughness sqrt(disc)) per crossing in front of the origin.
+     */
+    inline double Metallic::pdf(const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const
+    {
+        Vector3 w = direction.normalize();
+        if (isSpecular() || Vector3::dot(hitInfo.normal, w) <= 0.0)
+            return 0.0;
+
+        Vector3 r = Vector3::reflect(rayIn.direction.normalize(), hitInfo.normal);
+        double b = Vector3::dot(r, w);
+        double disc = b * b - 1.0 + m_roughness * m_roughness;
+        if (disc <= 0.0)
+            return 0.0;
+
+        double sqrtDisc = std::sqrt(disc);
+        double tNear = b - sqrtDisc;
+        double tFar = b + sqrtDisc;
+        double sumSquared = (tNear > 0.0 ? tNear * tNear : 0.0) + (tFar > 0.0 ? tFar * tFar : 0.0);
+        return sumSquared / (4.0 * math::PI * m_roughness * sqrtDisc);
+    }
+
+    // Directions below the surface are absorbed, so scatterRay's atten of
+    // m_color makes the BSDF times cosine m_color times the pdf.
+    inline Color Metallic::eval(const Ray &rayIn, const HitInfo &hitInfo, const Vector3 &direction) const
+    {
+        return m_color * pdf(rayIn, hitInfo, direction);
+    }
 }
 
 #endif
\ No newline at end of file
@@ -4,9 +4,18 @@
 #include "./geo/geometry_list.h"
 #include "./geo/sphere.h"
 #include "./geo/mesh.h"
+#include "./geo/instance.h"
 #include "./material/lambert.h"
 #include "./material/metallic.h"
 #include "./material/dielectric.h"
+#include "./material/emissive.h"
+#include "./material/material_table.h"
+#include "./light/area_light.h"
+#include "./light/light_list.h"
+#include "./sampler/sampler.h"
+#include "./sampler/halton_sampler.h"
+#include "./sampler/sobol_sampler.h"
+#include "./sampler/blue_noise_sampler.h"
 #include "./utils/hitinfo.h"
 #include "./utils/image.h"
 #include "./utils/ray.h"
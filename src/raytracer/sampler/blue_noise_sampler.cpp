@@ -0,0 +1,164 @@
+#include "blue_noise_sampler.h"
+
+#include <cmath>
+
+using namespace raytracer;
+
+namespace
+{
+    const int SIZE = BlueNoiseSampler::MASK_SIZE;
+    const int PIXEL_COUNT = SIZE * SIZE;
+    // Gaussian filter of the void-and-cluster energy, cut off at KERNEL_RADIUS.
+    const double SIGMA = 1.5;
+    const int KERNEL_RADIUS = 6;
+    const int KERNEL_SIZE = 2 * KERNEL_RADIUS + 1;
+
+    // Pixels set in a binary pattern, and the filtered density of the set
+    // pixels at every pixel. The mask tiles, so the filter wraps around.
+    struct DotPattern
+    {
+        std::vector<uint8_t> isSet = std::vector<uint8_t>(PIXEL_COUNT, 0);
+        std::vector<double> energy = std::vector<double>(PIXEL_COUNT, 0.0);
+        const std::vector<double> *kernel = nullptr;
+
+        void toggle(int pixel)
+        {
+            double sign = isSet[pixel] ? -1.0 : 1.0;
+            isSet[pixel] = !isSet[pixel];
+
+            int px = pixel % SIZE;
+            int py = pixel / SIZE;
+            for (int dy = -KERNEL_RADIUS; dy <= KERNEL_RADIUS; dy++)
+            {
+                int y = (py + dy + SIZE) % SIZE;
+                for (int dx = -KERNEL_RADIUS; dx <= KERNEL_RADIUS; dx++)
+                {
+                    int x = (px + dx + SIZE) % SIZE;
+                    energy[y * SIZE + x] += sign * (*kernel)[(dy + KERNEL_RADIUS) * KERNEL_SIZE + dx + KERNEL_RADIUS];
+                }
+            }
+        }
+
+        // Set pixel with the highest density.
+        int getTightestCluster() const
+        {
+            int best = -1;
+            for (int i = 0; i < PIXEL_COUNT; i++)
+                if (isSet[i] && (best < 0 || energy[i] > energy[best]))
+                    best = i;
+            return best;
+        }
+
+        // Unset pixel with the lowest density.
+        int getLargestVoid() const
+        {
+            int best = -1;
+            for (int i = 0; i < PIXEL_COUNT; i++)
+                if (!isSet[i] && (best < 0 || energy[i] < energy[best]))
+                    best = i;
+            return best;
+        }
+    };
+
+    /**
+     * Ranks every pixel by the order in which the void-and-cluster method
+     * adds it to an evenly spread dot pattern (Ulichney, 1993).
+     */
+    std::vector<float> buildMask()
+    {
+        std::vector<double> kernel(KERNEL_SIZE * KERNEL_SIZE);
+        for (int dy = -KERNEL_RADIUS; dy <= KERNEL_RADIUS; dy++)
+            for (int dx = -KERNEL_RADIUS; dx <= KERNEL_RADIUS; dx++)
+                kernel[(dy + KERNEL_RADIUS) * KERNEL_SIZE + dx + KERNEL_RADIUS] = std::exp(-(dx * dx + dy * dy) / (2.0 * SIGMA * SIGMA));
+
+        // Random initial pattern covering a tenth of the pixels, relaxed by
+        // moving the tightest cluster into the largest void until stable.
+        DotPattern prototype;
+        prototype.kernel = &kernel;
+        math::Random random(0);
+        int setCount = 0;
+        while (setCount < PIXEL_COUNT / 10)
+        {
+            int pixel = static_cast<int>(random.next() * PIXEL_COUNT);
+            if (!prototype.isSet[pixel])
+            {
+                prototype.toggle(pixel);
+                setCount++;
+            }
+        }
+        // Bounded, in case it ends up cycling.
+        for (int i = 0; i < PIXEL_COUNT; i++)
+        {
+            int cluster = prototype.getTightestCluster();
+            prototype.toggle(cluster);
+            int largestVoid = prototype.getLargestVoid();
+            prototype.toggle(largestVoid);
+            if (largestVoid == cluster)
+                break;
+        }
+
+        std::vector<int> ranks(PIXEL_COUNT);
+
+        // Ranks below the prototype: remove the tightest clusters.
+        DotPattern pattern = prototype;
+        for (int rank = setCount - 1; rank >= 0; rank--)
+        {
+            int cluster = pattern.getTightestCluster();
+            pattern.toggle(cluster);
+            ranks[cluster] = rank;
+        }
+
+        // Ranks above: fill the largest voids. Past half full this is the
+        // same as removing the tightest clusters of unset pixels, since the
+        // densities of set and unset pixels add up to a constant.
+        pattern = prototype;
+        for (int rank = setCount; rank < PIXEL_COUNT; rank++)
+        {
+            int largestVoid = pattern.getLargestVoid();
+            pattern.toggle(largestVoid);
+            ranks[largestVoid] = rank;
+        }
+
+        std::vector<float> mask(PIXEL_COUNT);
+        for (int i = 0; i < PIXEL_COUNT; i++)
+            mask[i] = (ranks[i] + 0.5f) / PIXEL_COUNT;
+        return mask;
+    }
+
+    // Golden ratio and R2 lattice generators.
+    const double ALPHA_1D = 0.6180339887498949;
+    const double ALPHA_2D_X = 0.7548776662466927;
+    const double ALPHA_2D_Y = 0.5698402909980532;
+
+    inline double wrap(double u)
+    {
+        return u - std::floor(u);
+    }
+}
+
+const std::vector<float> &BlueNoiseSampler::getMask()
+{
+    static const std::vector<float> mask = buildMask();
+    return mask;
+}
+
+double BlueNoiseSampler::getMaskValue(uint32_t dimension, int component) const
+{
+    // Offsets depend on the sampler seed only, not on the pixel, so
+    // neighbouring pixels read neighbouring mask values.
+    uint64_t offset = math::hashSeed(math::hashSeed(m_seed, dimension), component);
+    int x = (m_x + static_cast<int>(offset & 0xFFFF)) % MASK_SIZE;
+    int y = (m_y + static_cast<int>((offset >> 16) & 0xFFFF)) % MASK_SIZE;
+    return getMask()[y * MASK_SIZE + x];
+}
+
+double BlueNoiseSampler::sample1D(uint32_t dimension)
+{
+    return wrap(getMaskValue(dimension, 0) + m_sampleIndex * ALPHA_1D);
+}
+
+Sample2D BlueNoiseSampler::sample2D(uint32_t dimension)
+{
+    return {wrap(getMaskValue(dimension, 0) + m_sampleIndex * ALPHA_2D_X),
+            wrap(getMaskValue(dimension, 1) + m_sampleIndex * ALPHA_2D_Y)};
+}
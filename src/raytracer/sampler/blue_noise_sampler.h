@@ -0,0 +1,41 @@
+#ifndef BLUE_NOISE_SAMPLER_H
+#define BLUE_NOISE_SAMPLER_H
+
+#include "sampler.h"
+
+#include <vector>
+
+namespace raytracer
+{
+    /**
+     * @brief Dithers a rank 1 lattice (golden ratio and R2 sequences) over
+     * the samples of a pixel with a blue noise mask across pixels, after
+     * Georgiev and Fajardo, "Blue-noise Dithered Sampling", 2016. The error
+     * left at low sample counts is pushed to high frequencies, which reads
+     * as finer grain than white noise.
+     *
+     * Each dimension looks the mask up at its own toroidal offset.
+     */
+    class BlueNoiseSampler : public Sampler
+    {
+    protected:
+        double sample1D(uint32_t dimension) override;
+        Sample2D sample2D(uint32_t dimension) override;
+
+        double getMaskValue(uint32_t dimension, int component) const;
+
+    public:
+        // Side of the tileable mask, in pixels.
+        static constexpr int MASK_SIZE = 64;
+
+        std::unique_ptr<Sampler> clone() const override { return std::make_unique<BlueNoiseSampler>(*this); }
+
+        /**
+         * Threshold mask of MASK_SIZE x MASK_SIZE values in (0, 1), row by
+         * row, built with Ulichney's void-and-cluster method on first use.
+         */
+        static const std::vector<float> &getMask();
+    };
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include "halton_sampler.h"
+
+#include <cmath>
+
+using namespace raytracer;
+
+namespace
+{
+    const uint32_t PRIMES[] = {
+        2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+        59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131,
+        137, 139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223,
+        227, 229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311};
+    const uint32_t PRIME_COUNT = sizeof(PRIMES) / sizeof(PRIMES[0]);
+}
+
+/**
+ * Digits are scrambled down to 32 bits of precision, past the last digit of
+ * index too, so the trailing zeros become random digits. Each permutation
+ * is an affine map digit * a + c (mod base), a permutation since base is
+ * prime. a and c are scaled from the hash halves with a multiply instead of
+ * a division.
+ */
+double HaltonSampler::scrambledRadicalInverse(uint32_t base, uint32_t index, uint64_t seed)
+{
+    const double invBase = 1.0 / base;
+    double invBaseN = 1.0;
+    uint64_t reversed = 0;
+    // Digits of index already visited, which the next permutation depends on.
+    uint64_t prefix = 0;
+    uint64_t prefixScale = 1;
+    for (int digitIndex = 0; invBaseN > 0x1.0p-32; digitIndex++)
+    {
+        uint32_t next = index / base;
+        uint32_t digit = index - next * base;
+
+        uint64_t hash = math::hashSeed(seed + digitIndex, prefix);
+        uint32_t a = 1 + static_cast<uint32_t>(((hash & 0xFFFFFFFFu) * (base - 1)) >> 32);
+        uint32_t c = static_cast<uint32_t>(((hash >> 32) * base) >> 32);
+        reversed = reversed * base + (static_cast<uint64_t>(digit) * a + c) % base;
+        invBaseN *= invBase;
+
+        if (index > 0)
+        {
+            prefix += digit * prefixScale;
+            prefixScale *= base;
+        }
+        index = next;
+    }
+    return std::fmin(reversed * invBaseN, 1.0 - 0x1.0p-53);
+}
+
+double HaltonSampler::sampleComponent(uint32_t dimension, int component) const
+{
+    uint64_t seed = math::hashSeed(getDimensionSeed(dimension), component);
+    uint32_t baseIndex = 2 * dimension + component;
+    if (baseIndex >= PRIME_COUNT)
+        return math::toUnitInterval(math::hashSeed(seed, m_sampleIndex));
+
+    return scrambledRadicalInverse(PRIMES[baseIndex], m_sampleIndex, seed);
+}
+
+double HaltonSampler::sample1D(uint32_t dimension)
+{
+    return sampleComponent(dimension, 0);
+}
+
+Sample2D HaltonSampler::sample2D(uint32_t dimension)
+{
+    return {sampleComponent(dimension, 0), sampleComponent(dimension, 1)};
+}
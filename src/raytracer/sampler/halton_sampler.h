@@ -0,0 +1,34 @@
+#ifndef HALTON_SAMPLER_H
+#define HALTON_SAMPLER_H
+
+#include "sampler.h"
+
+namespace raytracer
+{
+    /**
+     * @brief Halton sequence: the sample index written backwards in base b
+     * behind the radix point, with a different prime base per dimension.
+     * The digits are Owen scrambled with a hash per pixel and dimension.
+     * This keeps the stratification, decorrelates neighbouring pixels and
+     * breaks up the clumping of large bases at low sample counts.
+     * Dimensions past the prime table fall back to random numbers.
+     */
+    class HaltonSampler : public Sampler
+    {
+    protected:
+        double sample1D(uint32_t dimension) override;
+        Sample2D sample2D(uint32_t dimension) override;
+
+        // Component of a dimension: 2D dimensions use two bases.
+        double sampleComponent(uint32_t dimension, int component) const;
+
+    public:
+        std::unique_ptr<Sampler> clone() const override { return std::make_unique<HaltonSampler>(*this); }
+
+        // Radical inverse of index with every digit permuted by a hash of
+        // seed, the digit position and the digits before it.
+        static double scrambledRadicalInverse(uint32_t base, uint32_t index, uint64_t seed);
+    };
+}
+
+#endif
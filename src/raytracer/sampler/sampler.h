@@ -0,0 +1,103 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "../../math/math.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace raytracer
+{
+    struct Sample2D
+    {
+        double x;
+        double y;
+    };
+
+    /**
+     * @brief Supplies the numbers in [0, 1) that a path sample is built from.
+     * Each sample of a pixel is a point in a many dimensional unit cube. The
+     * renderer takes the pixel position and lens position from the first
+     * dimensions, and then a fixed block of dimensions per bounce, so every
+     * dimension means the same thing in every sample. Low discrepancy
+     * samplers spread the samples of a pixel evenly over each dimension,
+     * which converges faster than independent random numbers.
+     *
+     * A call to get1D() or get2D() takes one dimension. A sampler keeps per
+     * sample state, so every render thread works on its own clone().
+     */
+    class Sampler
+    {
+    protected:
+        uint64_t m_seed = 0;
+        // Mixed from m_seed and the pixel coordinates.
+        uint64_t m_pixelSeed = 0;
+        int m_x = 0;
+        int m_y = 0;
+        uint32_t m_sampleIndex = 0;
+        uint32_t m_dimension = 0;
+
+        virtual double sample1D(uint32_t dimension) = 0;
+        virtual Sample2D sample2D(uint32_t dimension) = 0;
+
+        // Seed for one dimension of the current pixel.
+        uint64_t getDimensionSeed(uint32_t dimension) const { return math::hashSeed(m_pixelSeed, dimension); }
+
+    public:
+        static constexpr uint32_t PIXEL_DIMENSION = 0;
+        static constexpr uint32_t LENS_DIMENSION = 1;
+        static constexpr uint32_t FIRST_BOUNCE_DIMENSION = 2;
+        // Dimensions reserved for each bounce: two for the material, which
+        // uses them in order, two for light sampling (picking a light and a
+        // point on it) and the last for Russian roulette.
+        static constexpr uint32_t DIMENSIONS_PER_BOUNCE = 5;
+
+        virtual ~Sampler() = default;
+
+        // Independent copy for another thread.
+        virtual std::unique_ptr<Sampler> clone() const = 0;
+
+        // Samplers with equal seeds produce equal samples.
+        void setSeed(uint64_t seed) { m_seed = seed; }
+
+        // Starts sample sampleIndex of the pixel (x, y), at dimension 0.
+        virtual void startSample(int x, int y, uint32_t sampleIndex)
+        {
+            m_pixelSeed = math::hashSeed(math::hashSeed(m_seed, static_cast<uint32_t>(x)), static_cast<uint32_t>(y));
+            m_x = x;
+            m_y = y;
+            m_sampleIndex = sampleIndex;
+            m_dimension = 0;
+        }
+
+        void setDimension(uint32_t dimension) { m_dimension = dimension; }
+        static uint32_t getBounceDimension(int bounce) { return FIRST_BOUNCE_DIMENSION + bounce * DIMENSIONS_PER_BOUNCE; }
+        static uint32_t getLightDimension(int bounce) { return getBounceDimension(bounce) + 2; }
+        static uint32_t getRouletteDimension(int bounce) { return getBounceDimension(bounce) + DIMENSIONS_PER_BOUNCE - 1; }
+
+        // Next dimension of the current sample.
+        double get1D() { return sample1D(m_dimension++); }
+        Sample2D get2D() { return sample2D(m_dimension++); }
+    };
+
+    /**
+     * @brief Independent uniform random numbers from the thread generator.
+     * The baseline the other samplers are measured against.
+     */
+    class RandomSampler : public Sampler
+    {
+    protected:
+        double sample1D(uint32_t dimension) override { return math::random(); }
+        Sample2D sample2D(uint32_t dimension) override
+        {
+            double x = math::random();
+            double y = math::random();
+            return {x, y};
+        }
+
+    public:
+        std::unique_ptr<Sampler> clone() const override { return std::make_unique<RandomSampler>(*this); }
+    };
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include "sobol_sampler.h"
+
+using namespace raytracer;
+
+namespace
+{
+    inline uint32_t reverseBits(uint32_t x)
+    {
+        x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+        x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+        x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+        x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+        return (x >> 16) | (x << 16);
+    }
+
+    // Hash in which every bit depends only on the bits below it, so it acts
+    // as a random Owen scramble on the reversed bits.
+    inline uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed)
+    {
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return x;
+    }
+
+    inline uint32_t nestedUniformScramble(uint32_t x, uint32_t seed)
+    {
+        return reverseBits(laineKarrasPermutation(reverseBits(x), seed));
+    }
+
+    /**
+     * Second Sobol dimension, from the primitive polynomial x + 1. The first
+     * is the van der Corput sequence, reverseBits(index). A Sobol point is
+     * the XOR of the direction numbers of the set index bits, so it is
+     * tabulated per index byte: four lookups instead of a branch per bit,
+     * which mispredicts on scrambled indices.
+     */
+    struct SobolTable
+    {
+        uint32_t bytes[4][256];
+
+        SobolTable()
+        {
+            uint32_t directions[32];
+            directions[0] = 1u << 31;
+            for (int i = 1; i < 32; i++)
+                directions[i] = directions[i - 1] ^ (directions[i - 1] >> 1);
+
+            for (int byte = 0; byte < 4; byte++)
+            {
+                for (uint32_t value = 0; value < 256; value++)
+                {
+                    uint32_t x = 0;
+                    for (int bit = 0; bit < 8; bit++)
+                        if (value & (1u << bit))
+                            x ^= directions[8 * byte + bit];
+                    bytes[byte][value] = x;
+                }
+            }
+        }
+    };
+
+    const SobolTable SOBOL_TABLE;
+
+    inline uint32_t sobolSecondDimension(uint32_t index)
+    {
+        return SOBOL_TABLE.bytes[0][index & 0xFF] ^
+               SOBOL_TABLE.bytes[1][(index >> 8) & 0xFF] ^
+               SOBOL_TABLE.bytes[2][(index >> 16) & 0xFF] ^
+               SOBOL_TABLE.bytes[3][index >> 24];
+    }
+
+    inline double toUnitInterval(uint32_t x)
+    {
+        return x * 0x1.0p-32;
+    }
+}
+
+/**
+ * The 64-bit dimension seed provides the index and x scramble seeds. The
+ * first Sobol dimension is reverseBits(index), and scrambling it reverses
+ * the bits again, so x skips both reversals.
+ */
+double SobolSampler::sample1D(uint32_t dimension)
+{
+    uint64_t seed = getDimensionSeed(dimension);
+    uint32_t index = nestedUniformScramble(m_sampleIndex, static_cast<uint32_t>(seed));
+    uint32_t x = reverseBits(laineKarrasPermutation(index, static_cast<uint32_t>(seed >> 32)));
+    return toUnitInterval(x);
+}
+
+Sample2D SobolSampler::sample2D(uint32_t dimension)
+{
+    uint64_t seed = getDimensionSeed(dimension);
+    uint32_t index = nestedUniformScramble(m_sampleIndex, static_cast<uint32_t>(seed));
+    uint32_t x = reverseBits(laineKarrasPermutation(index, static_cast<uint32_t>(seed >> 32)));
+    uint32_t y = nestedUniformScramble(sobolSecondDimension(index), static_cast<uint32_t>(math::hashSeed(seed, 1)));
+    return {toUnitInterval(x), toUnitInterval(y)};
+}
@@ -0,0 +1,29 @@
+#ifndef SOBOL_SAMPLER_H
+#define SOBOL_SAMPLER_H
+
+#include "sampler.h"
+
+namespace raytracer
+{
+    /**
+     * @brief Owen scrambled Sobol sequence, using the hash based scrambling
+     * and padding of Burley, "Practical Hash-based Owen Scrambling", 2020.
+     *
+     * Every dimension is drawn from the first two Sobol dimensions, whose
+     * 2D projections are well stratified. Dimensions are decorrelated by
+     * shuffling the sample index with a per pixel and dimension Owen
+     * scramble, and the values are Owen scrambled as well. Works best with
+     * a power of 2 number of samples per pixel.
+     */
+    class SobolSampler : public Sampler
+    {
+    protected:
+        double sample1D(uint32_t dimension) override;
+        Sample2D sample2D(uint32_t dimension) override;
+
+    public:
+        std::unique_ptr<Sampler> clone() const override { return std::make_unique<SobolSampler>(*this); }
+    };
+}
+
+#endif
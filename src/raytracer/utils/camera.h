@@ -62,12 +62,28 @@ namespace raytracer
               m_viewportHeight{static_cast<float>(2.0 * tan(math::degreeToRadians(fov) / 2.0))},
               m_viewportWidth{m_aspectRatio * m_viewportHeight} {}
 
-        // Returns a ray from the given uv co-ordinates
+        // Returns a ray from the given uv co-ordinates, through a random
+        // point of the lens.
         Ray getRay(double x, double y) const
         {
-            Vector3 offset = Vector3::randomCircular() * (m_aperture / 2.0);
+            Vector3 lens = Vector3::randomCircular();
+            return getRayThroughLens(x, y, lens.x(), lens.y());
+        }
+
+        // Returns a ray from the given uv co-ordinates, through the point of
+        // the lens picked by two uniform numbers in [0, 1).
+        Ray getRay(double x, double y, double lensU, double lensV) const
+        {
+            Vector3 lens = Vector3::sampleDisk(lensU, lensV);
+            return getRayThroughLens(x, y, lens.x(), lens.y());
+        }
+
+    private:
+        // lensX and lensY are a point in the unit disk.
+        Ray getRayThroughLens(double x, double y, double lensX, double lensY) const
+        {
             // Orient the offset x-y plane to match camera orientation
-            offset = offset * u;
+            Vector3 offset = (lensX * u + lensY * v) * (m_aperture / 2.0);
             return Ray(m_position + offset,
                        lowerLeftCorner 
                        + x * u * m_focusDistance * m_viewportWidth 
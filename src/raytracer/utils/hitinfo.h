@@ -4,16 +4,15 @@
 #include "../../math/math.h"
 #include "ray.h"
 
-#include <memory>
+#include <cstdint>
 
 using math::Point;
 using math::Vector3;
 
-using std::shared_ptr;
-
 namespace raytracer
 {
-    class Material;
+    // Material index of geometry without a material of its own.
+    constexpr uint32_t NO_MATERIAL = UINT32_MAX;
 
     struct HitInfo
     {
@@ -21,7 +20,12 @@ namespace raytracer
         Vector3 normal = Point::zero;
         double distInRay = -1.0;
         bool isFrontFace = true;
-        shared_ptr<Material> material = nullptr;
+        // Index into the scene MaterialTable.
+        uint32_t materialIndex = NO_MATERIAL;
+        // Index of the hit object in the outermost GeometryList.
+        uint32_t objectIndex = UINT32_MAX;
+        // Triangle of the hit mesh, 0 for other geometry.
+        uint32_t primitiveIndex = 0;
 
         inline void setFaceNormal(const Vector3 &rayDir, const Vector3 &outwardNormal)
         {
@@ -1,6 +1,8 @@
 #ifndef IMAGE_H
 #define IMAGE_H
 
+#include <cstdint>
+
 namespace raytracer
 {
     class Image
@@ -12,6 +14,14 @@ namespace raytracer
         int m_samplesPerPixel = 16;
         int m_maxBounces = 6;
         uint8_t m_colorChannels = 3;
+        bool m_isDeterministic = false;
+        uint64_t m_seed = 0;
+        bool m_isAdaptive = false;
+        int m_minSamplesPerPixel = 4;
+        double m_adaptiveThreshold = 0.02;
+        int m_russianRouletteDepth = 3;
+        int m_tileSize = 16;
+        bool m_isProgressive = false;
 
     public:
         const float &aspectRatio = m_aspectRatio;
@@ -20,11 +30,51 @@ namespace raytracer
         int &samplesPerPixel = m_samplesPerPixel;
         int &maxBounces = m_maxBounces;
         uint8_t &colorChannels = m_colorChannels;
+        // When set, the random numbers of every sample are seeded from the
+        // pixel, the sample index and seed, so renders are bit identical
+        // across runs and thread counts.
+        bool &isDeterministic = m_isDeterministic;
+        uint64_t &seed = m_seed;
+        // When set, every pixel takes minSamplesPerPixel samples, then keeps
+        // doubling its sample count up to samplesPerPixel while the relative
+        // standard error of its luminance is above adaptiveThreshold.
+        bool &isAdaptive = m_isAdaptive;
+        int &minSamplesPerPixel = m_minSamplesPerPixel;
+        double &adaptiveThreshold = m_adaptiveThreshold;
+        // Bounces after which paths are randomly terminated with a
+        // probability that grows as their throughput drops. Survivors are
+        // weighted up, so the image stays unbiased.
+        int &russianRouletteDepth = m_russianRouletteDepth;
+        // Side in pixels of the square tiles the render threads take in turn.
+        int &tileSize = m_tileSize;
+        // When set, the image is rendered in samplesPerPixel passes of one
+        // sample per pixel each, summed in a float buffer and resolved to
+        // the pixels after every pass, so a render stopped early is evenly
+        // converged. Adaptive sampling does not apply.
+        bool &isProgressive = m_isProgressive;
         
-        const char *targetImageLocation;
+        const char *targetImageLocation = nullptr;
 
         Image(int width, int height)
             : m_aspectRatio{static_cast<float>(width) / static_cast<float>(height)}, m_width{width}, m_height{height} {}
+        // The public references of the copy must refer to its own members,
+        // not to those of image.
+        Image(const Image &image)
+            : m_aspectRatio{image.m_aspectRatio},
+              m_width{image.m_width},
+              m_height{image.m_height},
+              m_samplesPerPixel{image.m_samplesPerPixel},
+              m_maxBounces{image.m_maxBounces},
+              m_colorChannels{image.m_colorChannels},
+              m_isDeterministic{image.m_isDeterministic},
+              m_seed{image.m_seed},
+              m_isAdaptive{image.m_isAdaptive},
+              m_minSamplesPerPixel{image.m_minSamplesPerPixel},
+              m_adaptiveThreshold{image.m_adaptiveThreshold},
+              m_russianRouletteDepth{image.m_russianRouletteDepth},
+              m_tileSize{image.m_tileSize},
+              m_isProgressive{image.m_isProgressive},
+              targetImageLocation{image.targetImageLocation} {}
     };
 }
 
@@ -19,6 +19,10 @@ namespace raytracer
         : m_origin {Vector3::zero}, m_direction {Vector3::forward} {}
         Ray(const Point &origin, const Vector3 &direction)
             : m_origin{origin}, m_direction{direction} {}
+        // The public references of the copy must refer to its own members,
+        // not to those of ray.
+        Ray(const Ray &ray)
+            : m_origin{ray.m_origin}, m_direction{ray.m_direction} {}
 
         Ray& operator=(const Ray& ray);
 
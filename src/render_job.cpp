@@ -0,0 +1,140 @@
+#include "render_job.h"
+
+#include <chrono>
+
+RenderJob::RenderJob(std::shared_ptr<State> state)
+    : m_state{std::move(state)},
+      m_done{m_state->completion.get_future().share()}
+{
+}
+
+bool RenderJob::finishWorker(State &state, std::exception_ptr error)
+{
+    if (error)
+    {
+        std::lock_guard<std::mutex> lock(state.errorMutex);
+        if (!state.error)
+            state.error = error;
+        state.isCancelled.store(true, std::memory_order_relaxed);
+    }
+
+    // The decrements form a release sequence, so the last worker sees the
+    // pixels and the error stored by any other.
+    return state.runningWorkers.fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+
+void RenderJob::complete(State &state)
+{
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - state.startTime;
+    state.elapsedNanoseconds.store(elapsed.count(), std::memory_order_relaxed);
+    if (state.error)
+        state.completion.set_exception(state.error);
+    else
+        state.completion.set_value();
+}
+
+double RenderStats::getRaysPerSecond() const
+{
+    return elapsedSeconds > 0.0 ? rays / elapsedSeconds : 0.0;
+}
+
+double RenderStats::getEtaSeconds() const
+{
+    if (tiles == 0)
+        return -1.0;
+    return elapsedSeconds * (tileCount - static_cast<double>(tiles)) / tiles;
+}
+
+int RenderJob::getTileCount() const
+{
+    return m_state ? m_state->scheduler.getTileCount() * m_state->passCount : 0;
+}
+
+int RenderJob::getCompletedTiles() const
+{
+    return static_cast<int>(getStats().tiles);
+}
+
+double RenderJob::getProgress() const
+{
+    int tileCount = getTileCount();
+    return tileCount > 0 ? static_cast<double>(getCompletedTiles()) / tileCount : 1.0;
+}
+
+int RenderJob::getPassCount() const
+{
+    return m_state ? m_state->passCount : 0;
+}
+
+int RenderJob::getCompletedPasses() const
+{
+    return m_state ? m_state->completedPasses.load(std::memory_order_relaxed) : 0;
+}
+
+double RenderJob::getElapsedSeconds() const
+{
+    int64_t elapsed = m_state->elapsedNanoseconds.load(std::memory_order_relaxed);
+    if (elapsed < 0)
+        elapsed = std::chrono::nanoseconds(std::chrono::steady_clock::now() - m_state->startTime).count();
+    return elapsed * 1e-9;
+}
+
+void RenderJob::addCounters(const WorkerCounters &counters, RenderStats &stats)
+{
+    stats.tiles += counters.tiles.load(std::memory_order_relaxed);
+    stats.samples += counters.samples.load(std::memory_order_relaxed);
+    stats.rays += counters.rays.load(std::memory_order_relaxed);
+    stats.busySeconds += counters.busyNanoseconds.load(std::memory_order_relaxed) * 1e-9;
+}
+
+RenderStats RenderJob::getStats() const
+{
+    RenderStats stats;
+    if (!m_state)
+        return stats;
+
+    stats.tileCount = getTileCount();
+    stats.elapsedSeconds = getElapsedSeconds();
+    for (const WorkerCounters &counters : m_state->counters)
+        addCounters(counters, stats);
+    return stats;
+}
+
+int RenderJob::getWorkerCount() const
+{
+    return m_state ? static_cast<int>(m_state->counters.size()) : 0;
+}
+
+RenderStats RenderJob::getWorkerStats(int worker) const
+{
+    RenderStats stats;
+    if (worker < 0 || worker >= getWorkerCount())
+        return stats;
+
+    stats.tileCount = getTileCount();
+    stats.elapsedSeconds = getElapsedSeconds();
+    addCounters(m_state->counters[worker], stats);
+    return stats;
+}
+
+void RenderJob::cancel()
+{
+    if (m_state)
+        m_state->isCancelled.store(true, std::memory_order_relaxed);
+}
+
+bool RenderJob::isCancelled() const
+{
+    return m_state && m_state->isCancelled.load(std::memory_order_relaxed);
+}
+
+bool RenderJob::isDone() const
+{
+    return !m_state || m_done.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void RenderJob::wait() const
+{
+    if (m_state)
+        m_done.get();
+}
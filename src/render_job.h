@@ -0,0 +1,164 @@
+#ifndef RENDER_JOB_H
+#define RENDER_JOB_H
+
+#include "raytracer/raytracer.h"
+#include "utils/tile_scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Progress of a render, summed over its workers or for one worker.
+struct RenderStats
+{
+    int tileCount = 0;
+    uint64_t tiles = 0;
+    uint64_t samples = 0;
+    // Camera, bounce and shadow rays.
+    uint64_t rays = 0;
+    // Time spent rendering tiles. Summed over workers, so it can exceed
+    // elapsedSeconds.
+    double busySeconds = 0.0;
+    // Wall clock time since the render started, up to when it finished.
+    double elapsedSeconds = 0.0;
+
+    // Average over elapsedSeconds.
+    double getRaysPerSecond() const;
+    // Seconds left at the average tile rate so far. Negative before the
+    // first tile is done.
+    double getEtaSeconds() const;
+};
+
+/**
+ * @brief Handle to a render started with Scene::renderAsync. Copies refer
+ * to the same render. Progress can be polled and the render cancelled from
+ * any thread.
+ *
+ * Cancellation is cooperative: workers check for it before taking each
+ * tile, so a cancelled render stops once the tiles in progress are done,
+ * and leaves the pixels of the other tiles as they were. Dropping every
+ * handle does not stop the render, and the scene must outlive it.
+ */
+class RenderJob
+{
+private:
+    friend class Scene;
+
+    /**
+     * Progress of one worker. Only that worker writes it, once per tile,
+     * so a plain load and store replaces the locked read-modify-write of
+     * fetch_add. Padded to a cache line, so publishing does not invalidate
+     * the counters of other workers, and pollers only ever read.
+     */
+    struct alignas(64) WorkerCounters
+    {
+        std::atomic<uint64_t> tiles{0};
+        std::atomic<uint64_t> samples{0};
+        std::atomic<uint64_t> rays{0};
+        std::atomic<int64_t> busyNanoseconds{0};
+
+        // Called by the owning worker after each tile.
+        void add(uint64_t tileSamples, uint64_t tileRays, int64_t tileNanoseconds)
+        {
+            tiles.store(tiles.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            samples.store(samples.load(std::memory_order_relaxed) + tileSamples, std::memory_order_relaxed);
+            rays.store(rays.load(std::memory_order_relaxed) + tileRays, std::memory_order_relaxed);
+            busyNanoseconds.store(busyNanoseconds.load(std::memory_order_relaxed) + tileNanoseconds, std::memory_order_relaxed);
+        }
+    };
+
+    // Shared by the handles and the workers of one render.
+    struct State
+    {
+        TileScheduler scheduler;
+        // One per worker, cloned from the sampler of the scene.
+        std::vector<std::unique_ptr<raytracer::Sampler>> samplers;
+        std::vector<WorkerCounters> counters;
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        // Wall clock duration of the render, stored by the last worker.
+        std::atomic<int64_t> elapsedNanoseconds{-1};
+        std::atomic<bool> isCancelled{false};
+        // Passes over the whole image, 1 unless the image is progressive.
+        int passCount;
+        // Also the index of the pass being rendered. Incremented by the
+        // last worker of a pass, before the workers of the next start.
+        std::atomic<int> completedPasses{0};
+        // Workers of the current pass yet to return. The last one starts
+        // the next pass or completes the job.
+        std::atomic<int> runningWorkers;
+        // First exception thrown by a worker.
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        std::promise<void> completion;
+
+        State(int width, int height, int tileSize, int workerCount, int passCount = 1)
+            : scheduler(width, height, tileSize, workerCount),
+              samplers(workerCount),
+              counters(workerCount),
+              passCount{passCount},
+              runningWorkers(workerCount) {}
+    };
+
+    std::shared_ptr<State> m_state;
+    std::shared_future<void> m_done;
+
+    explicit RenderJob(std::shared_ptr<State> state);
+
+    // Called by every worker as it returns from a pass, with the exception
+    // it threw if any. An exception cancels the rest of the render. Returns
+    // true for the last worker of the pass.
+    static bool finishWorker(State &state, std::exception_ptr error);
+    // Completes the future. Called once, after the last pass.
+    static void complete(State &state);
+
+    double getElapsedSeconds() const;
+    static void addCounters(const WorkerCounters &counters, RenderStats &stats);
+
+public:
+    // Handle to no render, which counts as done.
+    RenderJob() = default;
+
+    bool isValid() const { return m_state != nullptr; }
+
+    // Tiles of every pass.
+    int getTileCount() const;
+    int getCompletedTiles() const;
+    // Fraction of the tiles rendered, in [0, 1].
+    double getProgress() const;
+
+    int getPassCount() const;
+    // Passes over the whole image done so far. The pixels of the scene
+    // resolve the first getCompletedPasses() passes, or more.
+    int getCompletedPasses() const;
+
+    /**
+     * Counters summed over the workers. Reads the counters without
+     * stopping or locking the workers, so the sums may mix counts from
+     * either side of a tile still being published. Cheap enough to poll
+     * every frame.
+     */
+    RenderStats getStats() const;
+    int getWorkerCount() const;
+    // Counters of one worker, to compare how the tiles were shared out.
+    // Empty for a worker index out of range or a handle to no render.
+    RenderStats getWorkerStats(int worker) const;
+
+    // Asks the workers to stop before their next tile, and returns at once.
+    void cancel();
+    bool isCancelled() const;
+
+    // True once every worker has returned, whether the render finished or
+    // was cancelled.
+    bool isDone() const;
+    // Blocks until isDone(). Rethrows the exception of a failed worker.
+    void wait() const;
+    // Ready once isDone(). Invalid for a handle to no render.
+    const std::shared_future<void> &getFuture() const { return m_done; }
+};
+
+#endif
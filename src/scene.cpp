@@ -5,7 +5,7 @@ raytracer::GeometryList Scene::generateSceneFromModel(raytracer::Mesh mesh)
 
     using namespace raytracer;
 
-    shared_ptr<Material> groundMat = make_shared<Lambert>(Color::one * 0.5);
+    uint32_t groundMat = m_materials.add(make_shared<Lambert>(Color::one * 0.5));
 
     GeometryList geoList;
     // Create ground
@@ -13,17 +13,123 @@ raytracer::GeometryList Scene::generateSceneFromModel(raytracer::Mesh mesh)
 
     shared_ptr<Mesh> meshPtr = make_shared<Mesh>(mesh);
     geoList.add(meshPtr);
+    geoList.buildBVH();
 
     m_currenGeoList = geoList;
 
     return geoList;
 }
 
-raytracer::GeometryList Scene::generateRandomScene()
+/**
+ * Lays out a rows x columns grid of copies of the mesh on the ground, each
+ * with a random rotation about the up axis. All copies reference the same
+ * mesh data and BVH.
+ */
+raytracer::GeometryList Scene::generateInstancedScene(raytracer::Mesh mesh, int rows, int columns)
 {
     using namespace raytracer;
+    using math::Matrix4;
 
-    shared_ptr<Material> groundMat = make_shared<Lambert>(Color::one * 0.5);
+    uint32_t groundMat = m_materials.add(make_shared<Lambert>(Color::one * 0.5));
+
+    GeometryList geoList;
+    // Create ground
+    geoList.add(make_shared<Sphere>(1000.0, Point(0.0, -1000.0, 0.0), groundMat));
+
+    shared_ptr<Mesh> meshPtr = make_shared<Mesh>(mesh);
+    AABB meshBounds = meshPtr->getBounds();
+    if (meshBounds.isEmpty())
+    {
+        m_currenGeoList = geoList;
+        return geoList;
+    }
+
+    Vector3 extent = meshBounds.extent();
+    double spacing = 1.25 * std::max(extent.x(), extent.z());
+    Point meshBase(meshBounds.centroid().x(), meshBounds.min.y(), meshBounds.centroid().z());
+
+    for (int r = 0; r < rows; r++)
+    {
+        for (int c = 0; c < columns; c++)
+        {
+            Point pos((c - (columns - 1) / 2.0) * spacing, 0.0, -r * spacing);
+            Matrix4 transform = Matrix4::translate(pos) *
+                                Matrix4::rotate(Vector3::up, math::random(0.0, 360.0)) *
+                                Matrix4::translate(-meshBase);
+            geoList.add(make_shared<Instance>(meshPtr, transform));
+        }
+    }
+    geoList.buildBVH();
+
+    m_currenGeoList = geoList;
+
+    return geoList;
+}
+
+namespace
+{
+    // Two triangles spanning the corners a, b, c, d, in order around the quad.
+    void addQuad(raytracer::GeometryList &geoList, const Point &a, const Point &b, const Point &c, const Point &d, uint32_t material)
+    {
+        using namespace raytracer;
+
+        Vector3 normal = Vector3::cross(b - a, c - a).normalize();
+        vector<Vector3> normals{normal, normal, normal};
+        geoList.add(make_shared<Triangle>(material, vector<Point>{a, b, c}, normals, vector<Vector3>(), vector<Color>(), 0));
+        geoList.add(make_shared<Triangle>(material, vector<Point>{a, c, d}, normals, vector<Vector3>(), vector<Color>(), 0));
+    }
+}
+
+/**
+ * Closed room, 5 units wide and tall, from z = -2.5 to z = 10. It is lit
+ * by a square light in the ceiling and a small light sphere on the floor.
+ * The whole scene is in view of a camera at (0, 2.5, 9) looking at
+ * (0, 2.5, 0) with a 40 degree field of view.
+ */
+raytracer::GeometryList Scene::generateCornellBoxScene()
+{
+    using namespace raytracer;
+
+    uint32_t white = m_materials.add(make_shared<Lambert>(Color(0.73, 0.73, 0.73)));
+    uint32_t red = m_materials.add(make_shared<Lambert>(Color(0.65, 0.05, 0.05)));
+    uint32_t green = m_materials.add(make_shared<Lambert>(Color(0.12, 0.45, 0.15)));
+    uint32_t ceilingLight = m_materials.add(make_shared<Emissive>(Color(1.0, 0.9, 0.75), 15.0));
+    uint32_t sphereLight = m_materials.add(make_shared<Emissive>(Color(0.6, 0.8, 1.0), 20.0));
+    uint32_t glass = m_materials.add(make_shared<Dielectric>(Color::one, 1.51));
+    uint32_t metal = m_materials.add(make_shared<Metallic>(Color(0.8, 0.85, 0.9), 0.1));
+
+    const double x0 = -2.5, x1 = 2.5, y0 = 0.0, y1 = 5.0, z0 = -2.5, z1 = 10.0;
+
+    GeometryList geoList;
+    addQuad(geoList, Point(x0, y0, z0), Point(x1, y0, z0), Point(x1, y0, z1), Point(x0, y0, z1), white); // Floor
+    addQuad(geoList, Point(x0, y1, z0), Point(x0, y1, z1), Point(x1, y1, z1), Point(x1, y1, z0), white); // Ceiling
+    addQuad(geoList, Point(x0, y0, z0), Point(x0, y1, z0), Point(x1, y1, z0), Point(x1, y0, z0), white); // Back
+    addQuad(geoList, Point(x0, y0, z1), Point(x1, y0, z1), Point(x1, y1, z1), Point(x0, y1, z1), white); // Front
+    addQuad(geoList, Point(x0, y0, z0), Point(x0, y0, z1), Point(x0, y1, z1), Point(x0, y1, z0), red);   // Left
+    addQuad(geoList, Point(x1, y0, z0), Point(x1, y1, z0), Point(x1, y1, z1), Point(x1, y0, z1), green); // Right
+
+    // Slightly below the ceiling, so it does not overlap it.
+    const double light = 0.75, lightY = y1 - 0.001;
+    addQuad(geoList, Point(-light, lightY, -light), Point(-light, lightY, light), Point(light, lightY, light), Point(light, lightY, -light), ceilingLight);
+
+    geoList.add(make_shared<Sphere>(0.2, Point(-1.8, 0.2, 2.0), sphereLight));
+    geoList.add(make_shared<Sphere>(1.0, Point(-1.0, 1.0, -0.5), white));
+    geoList.add(make_shared<Sphere>(0.8, Point(1.2, 0.8, 0.5), glass));
+    geoList.add(make_shared<Sphere>(0.6, Point(0.3, 0.6, 2.2), metal));
+    geoList.buildBVH();
+
+    m_currenGeoList = geoList;
+
+    return geoList;
+}
+
+raytracer::GeometryList Scene::generateRandomScene(uint64_t seed)
+{
+    using namespace raytracer;
+
+    math::Random random(seed);
+
+    uint32_t groundMat = m_materials.add(make_shared<Lambert>(Color::one * 0.5));
 
     GeometryList geoList;
 
@@ -33,59 +139,159 @@ raytracer::GeometryList Scene::generateRandomScene()
     {
         for (int y = 0; y < 8; y++)
         {
-            double randMat = math::random();
-            shared_ptr<Material> mat = groundMat;
+            double randMat = random.next();
+            uint32_t mat = groundMat;
             if (randMat < 0.2)
-                mat = make_shared<Dielectric>(Color::one, 1.51);
+                mat = m_materials.add(make_shared<Dielectric>(Color::one, 1.51));
             else if (randMat < 0.4)
-                mat = make_shared<Metallic>(Color::random(0.8, 1.0), math::random(0.025, 0.65));
+            {
+                // Drawn in separate statements, since the evaluation order of
+                // arguments is unspecified.
+                Color albedo = Color::random(random, 0.8, 1.0);
+                mat = m_materials.add(make_shared<Metallic>(albedo, random.next(0.025, 0.65)));
+            }
             else
-                mat = make_shared<Lambert>(Color::random(0.3, 1.0));
+                mat = m_materials.add(make_shared<Lambert>(Color::random(random, 0.3, 1.0)));
 
-            double randRadius = math::random(0.25, 1.0);
-            if (math::random() < 0.7)
-                randRadius = math::random(0.25, 0.5);
+            double randRadius = random.next(0.25, 1.0);
+            if (random.next() < 0.7)
+                randRadius = random.next(0.25, 0.5);
             else
-                randRadius = math::random(0.75, 1.0);
+                randRadius = random.next(0.75, 1.0);
 
             double randXPos = math::mapRange(static_cast<double>(x), 0.0, 8.0, -10.0, 10.0);
-            randXPos += math::random(-randRadius / 2.0, randRadius / 2.0);
+            randXPos += random.next(-randRadius / 2.0, randRadius / 2.0);
             double randZPos = math::mapRange(static_cast<double>(y), 0.0, 8.0, 0.0, -20.0);
-            randZPos += math::random(-randRadius / 2.0, randRadius / 2.0);
+            randZPos += random.next(-randRadius / 2.0, randRadius / 2.0);
             Point pos = Point(randXPos, randRadius, randZPos);
 
             shared_ptr<Sphere> randSphere = make_shared<Sphere>(randRadius, pos, mat);
             geoList.add(randSphere);
         }
     }
+    geoList.buildBVH();
 
     m_currenGeoList = geoList;
 
     return geoList;
 }
 
-Color Scene::getRayPixelColor(const raytracer::Ray &ray, const raytracer::Geometry &geo, int currBounce)
+namespace
+{
+    // Power heuristic with exponent 2 (Veach, 1997): the weight of a sample
+    // drawn with density pdf, when otherPdf could have drawn it too.
+    inline double getPowerHeuristic(double pdf, double otherPdf)
+    {
+        double pdfSquared = pdf * pdf;
+        double sum = pdfSquared + otherPdf * otherPdf;
+        return sum > 0.0 ? pdfSquared / sum : 0.0;
+    }
+}
+
+/**
+ * Light reaching the hit straight from a point sampled on one of the
+ * lights, if the shadow ray towards it is not blocked. Weighted against
+ * the material sampling the same direction.
+ */
+Color Scene::sampleDirectLight(const raytracer::Ray &ray, const raytracer::HitInfo &hit, const raytracer::Geometry &geo, int bounce, raytracer::Sampler &sampler, uint64_t &rays)
 {
-    raytracer::HitInfo hit;
+    sampler.setDimension(raytracer::Sampler::getLightDimension(bounce));
+    double uLight = sampler.get1D();
+    raytracer::Sample2D u = sampler.get2D();
+
+    raytracer::LightSample lightSample;
+    if (!m_lights.sample(hit.point, uLight, u, lightSample))
+        return Color::zero;
+
+    Color scattered = m_materials.eval(hit.materialIndex, ray, hit, lightSample.direction);
+    if (scattered.lengthSquared() <= 0.0)
+        return Color::zero;
 
-    if (currBounce <= 0)
+    // Stops short of the light, so the light itself does not block the ray.
+    raytracer::Ray shadowRay(hit.point, lightSample.direction);
+    rays++;
+    if (geo.isOccluded(shadowRay, 0.0001, lightSample.distance * (1.0 - 1e-4)))
         return Color::zero;
 
-    if (geo.isHit(ray, 0.0001, INFINITY, hit))
+    double materialPdf = m_materials.pdf(hit.materialIndex, ray, hit, lightSample.direction);
+    double weight = getPowerHeuristic(lightSample.pdf, materialPdf);
+    return scattered * lightSample.radiance * (weight / lightSample.pdf);
+}
+
+/**
+ * Follows the path one bounce at a time, carrying the product of the
+ * attenuations so far as the throughput.
+ *
+ * Hits on materials that are not specular add the light of one sampled
+ * point on the lights (next event estimation). The bounce ray leaving them
+ * can also run into a light, so both strategies are weighted with multiple
+ * importance sampling. Emission found after a specular bounce or from the
+ * camera has no light sampling counterpart and counts fully.
+ */
+Color Scene::getRayPixelColor(const raytracer::Ray &cameraRay, const raytracer::Geometry &geo, raytracer::Sampler &sampler, uint64_t &rays)
+{
+    raytracer::Ray ray = cameraRay;
+    Color throughput = Color::one;
+    Color radiance = Color::zero;
+    // Density of the material sampling the current ray, or 0 when the ray
+    // could not have been found by light sampling.
+    double materialPdf = 0.0;
+    Point scatterPoint = Point::zero;
+
+    for (int bounce = 0; bounce < m_image.maxBounces; bounce++)
     {
-        Color color = Color::zero;
+        raytracer::HitInfo hit;
+        rays++;
+        if (!geo.isHit(ray, 0.0001, INFINITY, hit))
+        {
+            /// Color the background
+            Vector3 normalizedDir = Vector3::normalize(ray.direction);
+            normalizedDir = (normalizedDir + Vector3::one) / 2.0;
+            return radiance + throughput * Vector3::lerp(Color(1.0, 1.0, 1.0), Color(0.5, 0.7, 1.0), normalizedDir.y());
+        }
+
+        Color emitted = m_materials.emitted(hit.materialIndex, hit);
+        if (emitted.lengthSquared() > 0.0)
+        {
+            double weight = 1.0;
+            if (materialPdf > 0.0)
+                weight = getPowerHeuristic(materialPdf, m_lights.pdf(scatterPoint, hit));
+            radiance += throughput * emitted * weight;
+        }
+
+        // The bounce ray of the last bounce is not traced, so the emission
+        // it would find through material sampling, the other half of the
+        // MIS pair, would be missing. Light sampling stops one bounce
+        // earlier as well, so both cover the same path lengths.
+        bool isSpecular = m_materials.isSpecular(hit.materialIndex);
+        if (!isSpecular && !m_lights.isEmpty() && bounce + 1 < m_image.maxBounces)
+            radiance += throughput * sampleDirectLight(ray, hit, geo, bounce, sampler, rays);
+
+        Color atten = Color::zero;
         raytracer::Ray outRay;
 
-        if (hit.material->scatterRay(ray, hit, color, outRay))
-            return color * getRayPixelColor(outRay, geo, --currBounce);
-        else
-            return Color::zero;
+        sampler.setDimension(raytracer::Sampler::getBounceDimension(bounce));
+        if (!m_materials.scatterRay(hit.materialIndex, ray, hit, atten, outRay, sampler))
+            return radiance;
+
+        materialPdf = isSpecular ? 0.0 : m_materials.pdf(hit.materialIndex, ray, hit, outRay.direction);
+        scatterPoint = hit.point;
+        throughput = throughput * atten;
+        ray = outRay;
+
+        // Survival probability follows the largest throughput component,
+        // capped so bright paths still terminate now and then.
+        if (bounce + 1 >= m_image.russianRouletteDepth)
+        {
+            double survival = std::min(std::max({throughput.x(), throughput.y(), throughput.z()}), 0.95);
+            sampler.setDimension(raytracer::Sampler::getRouletteDimension(bounce));
+            if (sampler.get1D() >= survival)
+                return radiance;
+            throughput /= survival;
+        }
     }
 
-    /// Color the background
-    Vector3 normalizedDir = Vector3::normalize(ray.direction);
-    normalizedDir = (normalizedDir + Vector3::one) / 2.0;
-    return Vector3::lerp(Color(1.0, 1.0, 1.0), Color(0.5, 0.7, 1.0), normalizedDir.y);
+    return radiance;
 }
 
 void Scene::processImageColor(Color &color, int samples)
@@ -93,42 +299,148 @@ void Scene::processImageColor(Color &color, int samples)
     color /= samples;
 
     // Gamma correction with gamma 2
-    color.x = sqrt(color.x);
-    color.y = sqrt(color.y);
-    color.z = sqrt(color.z);
+    color.x() = sqrt(color.x());
+    color.y() = sqrt(color.y());
+    color.z() = sqrt(color.z());
 
-    color.x = math::clamp(color.x, 0.0, 0.999);
-    color.y = math::clamp(color.y, 0.0, 0.999);
-    color.z = math::clamp(color.z, 0.0, 0.999);
+    color.x() = math::clamp(color.x(), 0.0, 0.999);
+    color.y() = math::clamp(color.y(), 0.0, 0.999);
+    color.z() = math::clamp(color.z(), 0.0, 0.999);
 }
 
-void Scene::renderPixels(int index, int start_x, int start_y, int end_x, int end_y, void (*callback)(uint8_t *), float *progress)
+uint64_t Scene::getSampleSeed(int x, int y, int sample) const
 {
-    Color color(1.0, 1.0, 1.0);
+    uint64_t seed = math::hashSeed(m_image.seed, static_cast<uint64_t>(y) * m_image.width + x);
+    return math::hashSeed(seed, sample);
+}
+
+Color Scene::renderSample(int x, int y, int sampleIndex, raytracer::Sampler &sampler, uint64_t &rays)
+{
+    if (m_image.isDeterministic)
+        math::seedRandom(getSampleSeed(x, y, sampleIndex));
+
+    sampler.startSample(x, y, sampleIndex);
+    sampler.setDimension(raytracer::Sampler::PIXEL_DIMENSION);
+    raytracer::Sample2D pixel = sampler.get2D();
+    raytracer::Sample2D lens = sampler.get2D();
+
+    double u = (x + pixel.x) / (m_image.width - 1);
+    double v = (m_image.height - 1 - (y + pixel.y)) / (m_image.height - 1);
+    return getRayPixelColor(m_camera.getRay(u, v, lens.x, lens.y), m_currenGeoList, sampler, rays);
+}
+
+/**
+ * Sample counts double between convergence checks. Checking after every
+ * sample would stop as soon as a few samples happen to agree, and power of
+ * 2 counts keep the Sobol sampler stratified.
+ */
+int Scene::renderPixel(int x, int y, raytracer::Sampler &sampler, Color &color, uint64_t &rays)
+{
+    const int maxSamples = std::max(1, m_image.samplesPerPixel);
+    int checkAt = m_image.isAdaptive ? std::min(std::max(m_image.minSamplesPerPixel, 1), maxSamples) : maxSamples;
 
-    int i = 0;
-    for (int y = start_y; y < end_y; ++y)
+    // Running mean and variance of the sample luminance (Welford).
+    double mean = 0.0;
+    double squaredDeviations = 0.0;
+
+    color = Color::zero;
+    int samples = 0;
+    while (samples < maxSamples)
     {
-        for (int x = start_x; x < end_x; ++x)
+        Color sample = renderSample(x, y, samples, sampler, rays);
+        color += sample;
+        samples++;
+
+        double luminance = 0.2126 * sample.x() + 0.7152 * sample.y() + 0.0722 * sample.z();
+        double delta = luminance - mean;
+        mean += delta / samples;
+        squaredDeviations += delta * (luminance - mean);
+
+        if (samples == checkAt)
         {
-            color = Color::zero;
-            for (int s = 0; s < m_image.samplesPerPixel; s++)
+            if (samples > 1)
             {
-                double u = (x + math::random()) / (m_image.width - 1);
-                double v = (m_image.height - 1 - (y + math::random())) / (m_image.height - 1);
-                color += getRayPixelColor(m_camera.getRay(u, v), m_currenGeoList, m_image.maxBounces);
+                // Standard error of the mean, relative to the mean. The floor
+                // keeps black pixels from dividing by zero.
+                double standardError = std::sqrt(squaredDeviations / (samples - 1) / samples);
+                if (standardError <= m_image.adaptiveThreshold * std::max(mean, 1e-3))
+                    break;
             }
-            processImageColor(color, m_image.samplesPerPixel);
-            m_pixels[index++] = static_cast<uint8_t>(color.x * 256);
-            m_pixels[index++] = static_cast<uint8_t>(color.y * 256);
-            m_pixels[index++] = static_cast<uint8_t>(color.z * 256);
+            checkAt = std::min(2 * checkAt, maxSamples);
+        }
+    }
+    return samples;
+}
+
+uint64_t Scene::renderTile(const Tile &tile, raytracer::Sampler &sampler, uint64_t &rays)
+{
+    Color color(1.0, 1.0, 1.0);
+    uint64_t tileSamples = 0;
+
+    for (int y = tile.y0; y < tile.y1; ++y)
+    {
+        int index = (y * m_image.width + tile.x0) * m_image.colorChannels;
+        for (int x = tile.x0; x < tile.x1; ++x)
+        {
+            int samples = renderPixel(x, y, sampler, color, rays);
+            m_sampleCounts[y * m_image.width + x] = samples;
+            tileSamples += samples;
+
+            processImageColor(color, samples);
+            m_pixels[index++] = static_cast<uint8_t>(color.x() * 256);
+            m_pixels[index++] = static_cast<uint8_t>(color.y() * 256);
+            m_pixels[index++] = static_cast<uint8_t>(color.z() * 256);
+        }
+    }
+    return tileSamples;
+}
 
-            *progress = (i + 1) / (end_x * end_y);
-            i++;
+uint64_t Scene::renderTilePass(const Tile &tile, int pass, raytracer::Sampler &sampler, uint64_t &rays)
+{
+    for (int y = tile.y0; y < tile.y1; ++y)
+    {
+        int pixel = y * m_image.width + tile.x0;
+        int index = pixel * m_image.colorChannels;
+        for (int x = tile.x0; x < tile.x1; ++x, ++pixel)
+        {
+            float *sum = &m_accumulation[3 * static_cast<size_t>(pixel)];
+            Color sample = renderSample(x, y, pass, sampler, rays);
+            sum[0] += static_cast<float>(sample.x());
+            sum[1] += static_cast<float>(sample.y());
+            sum[2] += static_cast<float>(sample.z());
+            m_sampleCounts[pixel] = pass + 1;
+
+            Color color(sum[0], sum[1], sum[2]);
+            processImageColor(color, pass + 1);
+            m_pixels[index++] = static_cast<uint8_t>(color.x() * 256);
+            m_pixels[index++] = static_cast<uint8_t>(color.y() * 256);
+            m_pixels[index++] = static_cast<uint8_t>(color.z() * 256);
         }
-        callback(m_pixels);
     }
+    return static_cast<uint64_t>(tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+}
 
+/**
+ * Counters are published once per tile into the cache line of the worker,
+ * so workers never write to shared memory while tracing.
+ */
+void Scene::renderTiles(int worker, RenderJob::State &job)
+{
+    RenderJob::WorkerCounters &counters = job.counters[worker];
+    int pass = job.completedPasses.load(std::memory_order_relaxed);
+    Tile tile;
+    // Checked between tiles only, so no tile is left half rendered.
+    while (!job.isCancelled.load(std::memory_order_relaxed) && job.scheduler.next(worker, tile))
+    {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t rays = 0;
+        uint64_t samples = m_image.isProgressive ? renderTilePass(tile, pass, *job.samplers[worker], rays)
+                                                 : renderTile(tile, *job.samplers[worker], rays);
+        std::chrono::nanoseconds busy = std::chrono::steady_clock::now() - start;
+
+        counters.add(samples, rays, busy.count());
+        m_callback(m_pixels);
+    }
 }
 
 void Scene::setOnPixelsProcessedListener(void (*callback)(uint8_t *pixels))
@@ -136,51 +448,101 @@ void Scene::setOnPixelsProcessedListener(void (*callback)(uint8_t *pixels))
     m_callback = callback;
 }
 
-void Scene::render(ThreadUsage threadUsage)
+void Scene::render(ThreadPool &pool)
+{
+    renderAsync(pool).wait();
+}
+
+void Scene::startPass(ThreadPool &pool, const std::shared_ptr<RenderJob::State> &job)
+{
+    int workers = job->scheduler.getWorkerCount();
+    job->runningWorkers.store(workers, std::memory_order_relaxed);
+
+    // Completion is signalled through the job, so the futures of the
+    // tasks are dropped. Each task keeps the job alive until it returns.
+    for (int worker = 0; worker < workers; worker++)
+    {
+        try
+        {
+            pool.submit([this, &pool, job, worker]
+                        {
+                            std::exception_ptr error;
+                            try
+                            {
+                                renderTiles(worker, *job);
+                            }
+                            catch (...)
+                            {
+                                error = std::current_exception();
+                            }
+                            finishPass(pool, job, error);
+                        });
+        }
+        catch (...)
+        {
+            // Workers that could not be queued return at once with the
+            // error, so the job still completes.
+            std::exception_ptr error = std::current_exception();
+            for (; worker < workers; worker++)
+                finishPass(pool, job, error);
+            return;
+        }
+    }
+}
+
+/**
+ * A pass ends when its last worker returns, so every tile of the pass is
+ * resolved before any tile of the next one starts. The next pass is queued
+ * from that worker rather than waited for, which keeps the pool free of
+ * blocked tasks.
+ */
+void Scene::finishPass(ThreadPool &pool, const std::shared_ptr<RenderJob::State> &job, std::exception_ptr error)
 {
-    int numThreads = std::thread::hardware_concurrency();
-    switch (threadUsage)
+    if (!RenderJob::finishWorker(*job, error))
+        return;
+
+    if (job->isCancelled.load(std::memory_order_relaxed))
     {
-    case ThreadUsage::SINGLE:
-        numThreads = 1;
-        break;
-    case ThreadUsage::HALF:
-        numThreads /= 2;
-        break;
-    case ThreadUsage::MAX_MINUS_2:
-        numThreads -= 2;
-        break;
-    case ThreadUsage::MAX:
-    default:
-        break;
+        RenderJob::complete(*job);
+        return;
     }
 
+    int completedPasses = job->completedPasses.load(std::memory_order_relaxed) + 1;
+    job->completedPasses.store(completedPasses, std::memory_order_relaxed);
+    if (completedPasses >= job->passCount)
+    {
+        RenderJob::complete(*job);
+        return;
+    }
+
+    job->scheduler.reset();
+    startPass(pool, job);
+}
+
+RenderJob Scene::renderAsync(ThreadPool &pool)
+{
+    int numThreads = pool.getThreadCount();
+
     int width = m_image.width;
     int height = m_image.height;
-    int pixelsPerThread = width * height * static_cast<int>(m_image.colorChannels) / numThreads;
+    m_sampleCounts.assign(static_cast<size_t>(width) * height, 0);
+    m_lights.build(m_currenGeoList, m_materials);
 
-    std::thread threads[numThreads];
-    float progress[numThreads];
-    int currPixel = 0;
-    int currHeight = 0;
-    for (size_t i = 0; i < numThreads; i++)
+    int passCount = 1;
+    if (m_image.isProgressive)
     {
-        threads[i] = std::thread(&Scene::renderPixels, this, currPixel, 0, currHeight, width, currHeight + height / numThreads, m_callback, &progress[i]);
-        currPixel += pixelsPerThread;
-        currHeight += height / numThreads;
+        passCount = std::max(1, m_image.samplesPerPixel);
+        m_accumulation.assign(3 * static_cast<size_t>(width) * height, 0.0f);
     }
 
-    // float prog;
-    // for (size_t i = 0; i < numThreads; i++)
-    //     prog += progress[i];
-    // prog /= numThreads;
-    // prog *= 100.0;
-
-    // std::cout << "Progress: " << prog << "%" << std::endl << std::flush;
-
-    for (size_t i = 0; i < numThreads; i++)
+    auto state = std::make_shared<RenderJob::State>(width, height, m_image.tileSize, numThreads, passCount);
+    for (int i = 0; i < numThreads; i++)
     {
-        threads[i].join();
+        state->samplers[i] = m_sampler->clone();
+        state->samplers[i]->setSeed(m_image.seed);
     }
 
+    RenderJob job(state);
+    startPass(pool, state);
+    return job;
 }
@@ -3,37 +3,64 @@
 
 #include "raytracer/raytracer.h"
 #include "math/math.h"
+#include "render_job.h"
+#include "utils/thread_pool.h"
+#include "utils/tile_scheduler.h"
 
-#include <thread>
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 
-enum class ThreadUsage
-{
-    MAX,
-    MAX_MINUS_2,
-    HALF,
-    SINGLE
-};
-
 class Scene
 {
 private:
     raytracer::GeometryList m_currenGeoList;
+    // Materials referenced by index from the geometry of the scene.
+    raytracer::MaterialTable m_materials;
+    // Emissive geometry of m_currenGeoList, gathered when rendering starts.
+    raytracer::LightList m_lights;
     raytracer::Camera m_camera;
     raytracer::Image m_image;
 
     uint8_t *m_pixels;
+    // Samples taken by each pixel in the last render, row by row.
+    std::vector<int> m_sampleCounts;
+    // Sum of the samples of each pixel in a progressive render, RGB row by
+    // row.
+    std::vector<float> m_accumulation;
 
     void (*m_callback)(uint8_t *pixels);
 
+    // Prototype cloned for every render thread.
+    std::unique_ptr<raytracer::Sampler> m_sampler = std::make_unique<raytracer::SobolSampler>();
+
     // raytracer::Mesh getMeshFromAttribs(tinyobj::attrib_t attribs,
     //                                    vector<tinyobj::shape_t> shapes,
     //                                    vector<tinyobj::material_t> meshMaterials);
 
-    Color getRayPixelColor(const raytracer::Ray &ray, const raytracer::Geometry &geo, int currBounce);
+    Color sampleDirectLight(const raytracer::Ray &ray, const raytracer::HitInfo &hit, const raytracer::Geometry &geo, int bounce, raytracer::Sampler &sampler, uint64_t &rays);
+    // Rays traced along the path, shadow rays included, are added to rays.
+    Color getRayPixelColor(const raytracer::Ray &cameraRay, const raytracer::Geometry &geo, raytracer::Sampler &sampler, uint64_t &rays);
     void processImageColor(Color &color, int samples);
-    void renderPixels(int index, int start_x, int start_y, int end_x, int end_y, void (*callback)(uint8_t *), float *progress);
+    Color renderSample(int x, int y, int sampleIndex, raytracer::Sampler &sampler, uint64_t &rays);
+    // Sums the samples of a pixel into color and returns their count.
+    int renderPixel(int x, int y, raytracer::Sampler &sampler, Color &color, uint64_t &rays);
+    // Seed of the random numbers of one sample in deterministic mode.
+    uint64_t getSampleSeed(int x, int y, int sample) const;
+    // Returns the samples taken by the pixels of tile.
+    uint64_t renderTile(const Tile &tile, raytracer::Sampler &sampler, uint64_t &rays);
+    // Adds sample pass of every pixel of tile to the accumulation buffer
+    // and resolves the pixels. Returns the samples taken.
+    uint64_t renderTilePass(const Tile &tile, int pass, raytracer::Sampler &sampler, uint64_t &rays);
+    // Renders the tiles the scheduler of job hands to worker until there
+    // are none left or the job is cancelled.
+    void renderTiles(int worker, RenderJob::State &job);
+    // Queues a task per worker rendering the current pass of job.
+    void startPass(ThreadPool &pool, const std::shared_ptr<RenderJob::State> &job);
+    // Called by each task of startPass as it returns. The last one starts
+    // the next pass, or completes the job.
+    void finishPass(ThreadPool &pool, const std::shared_ptr<RenderJob::State> &job, std::exception_ptr error);
 
 public:
     Scene()
@@ -64,11 +91,37 @@ public:
 
     const uint8_t &pixels = *m_pixels;
 
+    // Sample count AOV: samples taken by each pixel in the last render, row
+    // by row. Shows where adaptive sampling spent the budget.
+    const std::vector<int> &getSampleCounts() const { return m_sampleCounts; }
+    // Unresolved sums of the last progressive render, RGB row by row.
+    // Divide by the sample counts for the mean radiance of each pixel.
+    const std::vector<float> &getAccumulation() const { return m_accumulation; }
+
+    // Materials of the scene. Geometry passed to the generate functions
+    // must index materials added here.
+    raytracer::MaterialTable &getMaterials() { return m_materials; }
+
     // bool loadModelFromFile(const char *path);
     raytracer::GeometryList generateSceneFromModel(raytracer::Mesh mesh);
-    raytracer::GeometryList generateRandomScene();
+    raytracer::GeometryList generateInstancedScene(raytracer::Mesh mesh, int rows, int columns);
+    // Equal seeds give equal scenes.
+    raytracer::GeometryList generateRandomScene(uint64_t seed = 0);
+    // Closed room lit by area lights only.
+    raytracer::GeometryList generateCornellBoxScene();
     void setOnPixelsProcessedListener(void (*callback)(uint8_t *pixels));
-    void render(ThreadUsage threadUsage);
+    // Sampler of the pixel, lens and bounce dimensions. Owen scrambled
+    // Sobol by default.
+    void setSampler(std::unique_ptr<raytracer::Sampler> sampler) { m_sampler = std::move(sampler); }
+    // Renders on every worker of pool and returns once the image is done.
+    void render(ThreadPool &pool);
+    /**
+     * Starts rendering on every worker of pool and returns at once. The
+     * pixels fill in tile by tile, and pass by pass in a progressive
+     * render. Must not be called again, and the scene must not be changed,
+     * until the job is done. pool must outlive the job.
+     */
+    RenderJob renderAsync(ThreadPool &pool);
 };
 
 #endif
\ No newline at end of file
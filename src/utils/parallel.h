@@ -0,0 +1,41 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Splits [0, count) into numThreads contiguous chunks and calls
+ * func(begin, end, threadIndex) for each chunk on its own thread. The calling
+ * thread runs the first chunk. Returns once every chunk is done.
+ */
+template <typename Func>
+void parallelFor(int numThreads, uint32_t count, Func func)
+{
+    numThreads = std::max(1, std::min(numThreads, static_cast<int>(count)));
+    if (numThreads <= 1)
+    {
+        if (count > 0)
+            func(0u, count, 0);
+        return;
+    }
+
+    uint32_t chunkSize = (count + numThreads - 1) / numThreads;
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+
+    for (int t = 1; t < numThreads; t++)
+    {
+        uint32_t begin = std::min(count, t * chunkSize);
+        uint32_t end = std::min(count, begin + chunkSize);
+        threads.emplace_back(func, begin, end, t);
+    }
+    func(0u, std::min(count, chunkSize), 0);
+
+    for (std::thread &t : threads)
+        t.join();
+}
+
+#endif
@@ -0,0 +1,75 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+ThreadPool::ThreadPool(int threadCount)
+{
+    if (threadCount <= 0)
+        threadCount = getHardwareThreadCount();
+
+    m_workers.reserve(threadCount);
+    for (int i = 0; i < threadCount; i++)
+        m_workers.emplace_back(&ThreadPool::runWorker, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    shutdown();
+}
+
+int ThreadPool::getHardwareThreadCount()
+{
+    // hardware_concurrency() may return 0.
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+void ThreadPool::runWorker()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskAvailable.wait(lock, [this]
+                                 { return m_isStopping || !m_tasks.empty(); });
+            // Drain the queue before stopping, so no future is left unready.
+            if (m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+// std::function needs a copyable target, so the packaged task is shared.
+std::future<void> ThreadPool::submit(std::function<void()> task)
+{
+    auto packagedTask = std::make_shared<std::packaged_task<void()>>(std::move(task));
+    std::future<void> future = packagedTask->get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_isStopping)
+            throw std::runtime_error("ThreadPool::submit: the pool is shut down");
+        m_tasks.emplace_back([packagedTask]
+                             { (*packagedTask)(); });
+    }
+    m_taskAvailable.notify_one();
+    return future;
+}
+
+void ThreadPool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_isStopping)
+            return;
+        m_isStopping = true;
+    }
+    m_taskAvailable.notify_all();
+
+    for (std::thread &worker : m_workers)
+        worker.join();
+}
@@ -0,0 +1,55 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads that stay alive between renders and
+ * run submitted tasks in submission order. Starting a render on the pool
+ * costs a queue push per worker instead of creating and joining threads.
+ *
+ * Tasks must not wait on other tasks of the same pool, since every worker
+ * could end up waiting.
+ */
+class ThreadPool
+{
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_taskAvailable;
+    bool m_isStopping = false;
+
+    void runWorker();
+
+public:
+    // threadCount <= 0 uses every hardware thread.
+    explicit ThreadPool(int threadCount = 0);
+    // Runs the tasks already submitted, then joins the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int getThreadCount() const { return static_cast<int>(m_workers.size()); }
+
+    // Hardware threads of the machine, at least 1.
+    static int getHardwareThreadCount();
+
+    // Queues task and returns a future that is ready once it has run. An
+    // exception thrown by task is rethrown by the future.
+    std::future<void> submit(std::function<void()> task);
+
+    // Runs the tasks already submitted and joins the workers. Tasks
+    // submitted afterwards throw. Called by the destructor.
+    void shutdown();
+};
+
+#endif
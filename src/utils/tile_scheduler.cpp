@@ -0,0 +1,78 @@
+#include "tile_scheduler.h"
+
+#include <algorithm>
+
+TileScheduler::TileScheduler(int width, int height, int tileSize, int workerCount)
+    : m_queues(std::max(1, workerCount)),
+      m_width{width},
+      m_height{height},
+      m_tileSize{std::max(1, tileSize)}
+{
+    reset();
+}
+
+void TileScheduler::reset()
+{
+    int tilesX = (m_width + m_tileSize - 1) / m_tileSize;
+    int tilesY = (m_height + m_tileSize - 1) / m_tileSize;
+    m_tileCount = std::max(0, tilesX * tilesY);
+
+    for (WorkerQueue &queue : m_queues)
+        queue.tiles.clear();
+
+    // Row major, so each worker starts on a band of neighbouring tiles.
+    int workers = getWorkerCount();
+    for (int i = 0; i < m_tileCount; i++)
+    {
+        Tile tile;
+        tile.x0 = (i % tilesX) * m_tileSize;
+        tile.y0 = (i / tilesX) * m_tileSize;
+        tile.x1 = std::min(m_width, tile.x0 + m_tileSize);
+        tile.y1 = std::min(m_height, tile.y0 + m_tileSize);
+
+        int worker = static_cast<int>(static_cast<long long>(i) * workers / m_tileCount);
+        m_queues[worker].tiles.push_back(tile);
+    }
+}
+
+bool TileScheduler::popFront(int worker, Tile &tile)
+{
+    WorkerQueue &queue = m_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tiles.empty())
+        return false;
+
+    tile = queue.tiles.front();
+    queue.tiles.pop_front();
+    return true;
+}
+
+bool TileScheduler::popBack(int worker, Tile &tile)
+{
+    WorkerQueue &queue = m_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tiles.empty())
+        return false;
+
+    tile = queue.tiles.back();
+    queue.tiles.pop_back();
+    return true;
+}
+
+/**
+ * No tiles are added until the next reset, so once a pass over every
+ * deque finds them all empty the image is fully handed out.
+ */
+bool TileScheduler::next(int worker, Tile &tile)
+{
+    if (popFront(worker, tile))
+        return true;
+
+    int workers = getWorkerCount();
+    for (int i = 1; i < workers; i++)
+    {
+        if (popBack((worker + i) % workers, tile))
+            return true;
+    }
+    return false;
+}
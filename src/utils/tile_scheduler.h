@@ -0,0 +1,66 @@
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Rectangle of pixels [x0, x1) x [y0, y1).
+struct Tile
+{
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+};
+
+/**
+ * @brief Cuts an image into square tiles and hands them out to a fixed
+ * number of workers. Every worker starts with its own deque holding a
+ * contiguous run of tiles, which it works through from the front. A worker
+ * whose deque is empty steals from the back of another's, far from where
+ * that worker is busy, so the expensive parts of the image end up spread
+ * over every worker whatever the scene layout.
+ *
+ * Each deque has its own lock, which only its owner and the occasional
+ * thief contend for.
+ */
+class TileScheduler
+{
+private:
+    // Padded to a cache line, so workers locking their own deque do not
+    // invalidate each other's.
+    struct alignas(64) WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Tile> tiles;
+    };
+
+    std::vector<WorkerQueue> m_queues;
+    int m_width;
+    int m_height;
+    int m_tileSize;
+    int m_tileCount = 0;
+
+    bool popFront(int worker, Tile &tile);
+    bool popBack(int worker, Tile &tile);
+
+public:
+    TileScheduler(int width, int height, int tileSize, int workerCount);
+
+    int getTileCount() const { return m_tileCount; }
+    int getWorkerCount() const { return static_cast<int>(m_queues.size()); }
+
+    // Hands out every tile again, for another pass over the image. Must
+    // not be called while a worker may be calling next().
+    void reset();
+
+    /**
+     * Next tile for worker, from its own deque or stolen from another.
+     * Returns false once every tile has been handed out. Safe to call from
+     * all workers at once.
+     */
+    bool next(int worker, Tile &tile);
+};
+
+#endif
@@ -74,6 +74,8 @@ void Window::start()
 
 void Window::update()
 {
+    if (m_update_callback)
+        m_update_callback();
     m_renderer->update();
 }
 
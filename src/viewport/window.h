@@ -21,6 +21,7 @@ private:
     double m_prevMouseYPos;
 
     void (*m_render_callback)();
+    void (*m_update_callback)() = nullptr;
 
 protected:
     void handleInput();
@@ -39,6 +40,11 @@ public:
     {
         m_render_callback = callback;
     }
+    // Called once per frame, before the frame is drawn.
+    void setUpdateListener(void (*callback)())
+    {
+        m_update_callback = callback;
+    }
     void onWindowResized();
 };
 #endif
\ No newline at end of file